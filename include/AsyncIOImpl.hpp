@@ -62,8 +62,12 @@ and presenting it in a moving-window interface.
 #include <atomic>
 #include <memory>
 #include <algorithm>
+#include <chrono>
+#include <mutex>
 
 #include "DataSource.hpp"
+#include "BufferGovernor.hpp"
+#include "PageAllocator.hpp"
 
 using std::string;
 using std::unique_ptr; 
@@ -91,24 +95,79 @@ class AsyncIOInvalidException : public exception {
 	
 };
 
-template <class T>
+template <class T, unsigned int N = 0>
 class AsyncIOImpl {
 	
 	protected:
-		vector<T> data;
+		vector<T, PageAllocator<T>> data;
 		future<vector<T>> ft; 
 	
 		const unsigned int datapoints_limit; 
 		unsigned int datapoints_read; 
 		const unsigned int windowsize;  
 		unsigned int start; 
+		
+		//The index in the whole stream of the element the window starts at. 
+		unsigned long position; 
 	
 		atomic<bool> pendingio;
 		atomic<bool> readyio; 
+		
+		//Set by cancel(). The io functions check it between elements, so an
+		//outstanding read stops early instead of finishing its whole slice. 
+		atomic<bool> cancelled; 
 	
 		const launch policy; 
 	
+		//The number of elements the io functions should load on their next call.
+		//This is set before each load is launched and left alone while it runs. 
 		unsigned int read_extent;
+		
+		//A load that comes back short means the underlying source has run dry, 
+		//so no further loads are launched. Unless the source is streaming: then
+		//it may grow, and a short load just means the writer is behind. 
+		bool exhausted; 
+		bool streaming; 
+		
+		//User bounds on read_extent, in elements. 
+		unsigned int min_extent; 
+		unsigned int max_extent; 
+		
+		//How many windows may remain in the buffer before the next load is 
+		//launched: the prefetch distance. 
+		unsigned int lowwater; 
+		
+		//Run-time measurements that drive read_extent and lowwater. The io 
+		//latency is written by the io function before it returns, and only read
+		//after the future has been collected. 
+		double io_seconds; 
+		double io_latency; 
+		double consume_rate; 
+		unsigned int ticks; 
+		std::chrono::steady_clock::time_point lastread; 
+		
+		//Our account with the process-wide BufferGovernor, and the last of its
+		//trims we looked at. 
+		const unsigned long account; 
+		unsigned long trimsseen; 
+		
+		//Set by whenready(), and called by the io function when it finishes.
+		std::mutex waitlock; 
+		function<void()> waiter; 
+		
+		//readyio is set before the lock is taken, so whenready() either sees
+		//it or leaves a waiter that this will find. 
+		inline void notify() {
+			function<void()> callback; 
+			{
+				std::lock_guard<std::mutex> guard(waitlock); 
+				callback.swap(waiter); 
+			}
+			if(callback) callback(); 
+		}
+		
+		//The windowsize, folded to a constant when it is fixed at compile time. 
+		inline unsigned int getwindowsize() const { return N ? N : windowsize; }
 	
 		inline unsigned int nvalidwindows() const {
 			
@@ -118,11 +177,11 @@ class AsyncIOImpl {
 			
 			//if the vector contains fewer elements than the
 			//windowsize, then we don't have any valid windows
-			if((data.size() - start) < windowsize) return 0;
+			if((data.size() - start) < getwindowsize()) return 0;
 			
 			//otherwise, if we have the same (or more) elements
 			//as the windowsize, then we have at least one window. 
-			return ((data.size() - start) - windowsize) + 1; 
+			return ((data.size() - start) - getwindowsize()) + 1; 
 																		
 		}
 		
@@ -134,39 +193,212 @@ class AsyncIOImpl {
 			return datapoints_read == datapoints_limit; 
 		}
 		
+		//Wraps an io function so that its latency is measured. 
+		inline function<vector<T>()> timed(vector<T> (AsyncIOImpl<T, N>::*fn)()) {
+			
+			return [this, fn]() { 
+				auto t0 = std::chrono::steady_clock::now();
+				auto tmpdata = (this->*fn)();
+				this->io_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+				this->readyio = true; 
+				this->notify(); 
+				return tmpdata; 
+			};
+			
+		}
+		
+		inline size_t heldbytes() const {
+			return data.capacity() * sizeof(T); 
+		}
+		
+		//Ask the governor for room for the next load, and shrink it to what we 
+		//are given. We always allow ourselves a window's worth so that the 
+		//stream can make progress. 
+		inline void reserve() {
+			
+			size_t granted = BufferGovernor::instance().request(account, heldbytes(), (size_t) read_extent * sizeof(T)); 
+			
+			size_t allowed = std::max(granted / sizeof(T), (size_t) std::min(getwindowsize(), read_extent)); 
+			read_extent = (unsigned int) std::min((size_t) read_extent, allowed); 
+			
+		}
+		
+		inline void launchnext() {
+			
+			//Mark as pendingio. 
+			pendingio = true; 
+			
+			read_extent = std::min(std::max(read_extent, min_extent), max_extent);
+			reserve();
+			
+			ft = async(policy, timed(&AsyncIOImpl<T, N>::ionext));
+			
+		}
+		
+		//Resize the next load and the prefetch distance from what we have 
+		//measured. Each load should take several io latencies to consume, so 
+		//tiny windows don't produce a storm of tiny reads, and the next load 
+		//should be launched at least two io latencies before the buffer runs 
+		//out. Both are clamped to the user's bounds, so a huge window can't 
+		//produce a huge read unless it's allowed to. 
+		inline void adapt(bool stalled) {
+			
+			auto now = std::chrono::steady_clock::now(); 
+			double elapsed = std::chrono::duration<double>(now - lastread).count();
+			lastread = now; 
+			
+			io_latency = (io_latency == 0.0) ? io_seconds : 0.5 * io_latency + 0.5 * io_seconds; 
+			
+			if(ticks > 0 && elapsed > 0.0) {
+				double rate = ticks / elapsed; 
+				consume_rate = (consume_rate == 0.0) ? rate : 0.5 * consume_rate + 0.5 * rate; 
+			}
+			ticks = 0; 
+			
+			if(consume_rate == 0.0) return; 
+			
+			double inflight = consume_rate * io_latency; 
+			
+			double extent = std::ceil(inflight * 4.0); 
+			extent = std::max(extent, (double) min_extent); 
+			extent = std::min(extent, (double) max_extent); 
+			read_extent = (unsigned int) extent; 
+			
+			double water = std::ceil(inflight * 2.0) + 1.0; 
+			if(stalled) water = std::max(water, lowwater * 2.0); 
+			water = std::min(water, (double) max_extent); 
+			lowwater = (unsigned int) water; 
+			
+		}
+		
 		inline void read()  {
+			//If the load hasn't finished, the consumer is about to wait on it
+			bool stalled = ft.wait_for(std::chrono::seconds(0)) == std::future_status::timeout;
 			//remove past values
 			data.erase(data.begin(), data.begin() + start);
 			//get an append the new data
 			auto tmpdata = ft.get();
+			if(!streaming && tmpdata.size() < read_extent) exhausted = true; 
+			if(completed()) exhausted = true; 
 			data.insert(data.end(), tmpdata.begin(), tmpdata.end());
+			//settle up with the governor, giving memory back if we're told to
+			if(BufferGovernor::instance().update(account, heldbytes())) {
+				data.shrink_to_fit(); 
+				BufferGovernor::instance().update(account, heldbytes());
+			}
 			//update values. 
 			start = 0; 
 			pendingio = false; 
 			readyio = false; 
+			adapt(stalled);
+			loaded(); 
 		}
 		
-		inline void check()  {
+		//Give memory back if the governor has asked us to since we last 
+		//looked, even if we haven't loaded anything in the meantime. Only what
+		//has already been consumed, and spare capacity, can go. 
+		inline void trim() {
+			
+			unsigned long trims = BufferGovernor::instance().gettrims(); 
+			if(trims == trimsseen) return; 
+			trimsseen = trims; 
+			
+			if(!BufferGovernor::instance().trimrequested(account)) return; 
+			
+			data.erase(data.begin(), data.begin() + start);
+			start = 0; 
+			data.shrink_to_fit(); 
+			BufferGovernor::instance().update(account, heldbytes());
+			
+		}
+		
+		//Makes sure there is a valid window if there can be one. 
+		inline bool fill() {
+			//Nothing will ever arrive after a cancel. 
+			if(cancelled) return false;
+			trim(); 
 			//If there's something to pick up, pick it up
 			if(readyio) {
 				read();
 			}
 			//If there are no valid windows, we need to 
 			//check if there is a pending (but incomplete)
-			//io operation. 
-			if(!hasvalidwindow()) {
+			//io operation, or whether we can start one. 
+			while(!hasvalidwindow()) {
 				if(pendingio) {
 					read();
 				}
+				else if(!exhausted) {
+					launchnext();
+				}
 				else {
-					throw AsyncIOInvalidException();
+					return false;
 				}
 			}
+			return true; 
+		}
+		
+		inline void check()  {
+			if(!fill()) throw AsyncIOInvalidException();
 		}
 			
+		//Both load read_extent elements (or fewer, at the end of the data). 
 		virtual vector<T> ioinit() = 0; 
 		virtual vector<T> ionext() = 0; 
 		
+		//Called by cancel() before it waits on the outstanding io, so that an
+		//io function blocked waiting for data can be woken up. 
+		virtual void iowake() {}
+		
+		//Called on the consumer's side each time a load has been picked up. 
+		virtual void loaded() {}
+		
+		//Starts the first load. This can't happen in the constructor: with 
+		//launch::async the io function would run against a derived class that
+		//hasn't been constructed yet, so the derived constructors call this last. 
+		inline void prime() {
+			
+			lastread = std::chrono::steady_clock::now();
+			
+			reserve();
+			
+			ft = async(policy, timed(&AsyncIOImpl<T, N>::ioinit));
+			
+		}
+		
+		//Wait for any outstanding load and throw it away, so that the derived 
+		//class can reposition its reader. 
+		inline void settle() {
+			
+			if(cancelled) throw AsyncIOInvalidException(); 
+			
+			if(ft.valid()) {
+				if(ft.wait_for(std::chrono::seconds(0)) != std::future_status::deferred) {
+					ft.wait();
+				}
+				ft = future<vector<T>>();
+			}
+			
+			pendingio = false; 
+			readyio = false; 
+			
+		}
+		
+		//Throw away the buffer and start loading again from element index. The
+		//derived class has already put its reader there. 
+		inline void restart(unsigned long index) {
+			
+			data.clear(); 
+			start = 0; 
+			position = index; 
+			datapoints_read = index; 
+			exhausted = false; 
+			pendingio = true; 
+			
+			prime(); 
+			
+		}
+		
 	public:
 		AsyncIOImpl(unsigned int _wsize, launch _policy, int datapoints)  :
 			data(), 
@@ -175,28 +407,90 @@ class AsyncIOImpl {
 			datapoints_read(0),
 			windowsize(_wsize),
 			start(0),
+			position(0),
 			pendingio(true),
 			readyio(false),
-			policy(_policy)
+			cancelled(false),
+			policy(_policy),
+			exhausted(false),
+			streaming(false),
+			io_seconds(0.0),
+			io_latency(0.0),
+			consume_rate(0.0),
+			ticks(0),
+			account(BufferGovernor::instance().enroll()),
+			trimsseen(0), 
+			waitlock(),
+			waiter()
 		{
 			
-			read_extent = windowsize * 3; 
+			read_extent = getwindowsize() * 3; 
 			
-			data.reserve(read_extent);
+			min_extent = getwindowsize(); 
+			max_extent = std::max(getwindowsize() * 64, 65536u); 
 			
-			function<vector<T>()> finit = [&]() { return this->ioinit(); };
+			lowwater = getwindowsize(); 
 			
-			ft = async(policy, finit);
+			data.reserve(read_extent);
 			
 		}
 		
 		//Absolutely no copying. 
-		AsyncIOImpl(AsyncIOImpl<T> const & cpy) = delete; 
-		AsyncIOImpl<T>& operator =(const AsyncIOImpl<T>& cpy) = delete; 
+		AsyncIOImpl(AsyncIOImpl<T, N> const & cpy) = delete; 
+		AsyncIOImpl<T, N>& operator =(const AsyncIOImpl<T, N>& cpy) = delete; 
+		
+		AsyncIOImpl(AsyncIOImpl<T, N> && mv) = delete; 
+		AsyncIOImpl<T, N>& operator =(AsyncIOImpl<T, N> && mv) = delete; 
+		
+		//Derived classes must cancel() in their own destructors, before their
+		//members go away; this is only a backstop. 
+		~AsyncIOImpl() { 
+			cancel();
+		}
+		
+		//Stops any outstanding io at the next element and releases the buffer. 
+		//A deferred load that was never started is simply dropped. After this
+		//eods() is true and get() throws. 
+		void cancel() {
+			
+			cancelled = true; 
+			iowake(); 
+			
+			if(ft.valid()) {
+				if(ft.wait_for(std::chrono::seconds(0)) != std::future_status::deferred) {
+					ft.wait();
+				}
+				ft = future<vector<T>>();
+			}
+			
+			pendingio = false; 
+			readyio = false; 
+			
+			vector<T, PageAllocator<T>>().swap(data);
+			start = 0; 
+			
+			BufferGovernor::instance().withdraw(account);
+			
+		}
+		
+		//Bounds, in elements, on the size of each load. The buffer holds at most
+		//about one window, the prefetch distance and one load, all of which are
+		//kept within these bounds. 
+		void setreadbounds(unsigned int _min, unsigned int _max) {
+			
+			//read_extent may be in use by a running load, so it is only 
+			//brought within the new bounds when the next one is launched. 
+			min_extent = std::max(_min, 1u);
+			max_extent = std::max(_max, min_extent); 
+			
+			lowwater = std::min(lowwater, max_extent); 
+			
+		}
 		
-		AsyncIOImpl(AsyncIOImpl<T> && mv) = delete; 
-		AsyncIOImpl<T>& operator =(AsyncIOImpl<T> && mv) = delete; 
-		~AsyncIOImpl() = default; 
+		inline unsigned int getreadextent() const { return read_extent; }
+		inline unsigned long getposition() const { return position; }
+		inline unsigned int getprefetchdistance() const { return lowwater; }
+		inline size_t getheld() const { return heldbytes(); }
 		
 		T * get() { 
 			check();
@@ -211,19 +505,84 @@ class AsyncIOImpl {
 			check();
 			
 			start++;
+			position++;
+			ticks++;
 			
-			if(start == windowsize) {
+			//Time to load a new slice once we're within the prefetch distance 
+			//of running out. 
+			if(!pendingio && !exhausted && nvalidwindows() <= lowwater) {
+				launchnext();
+			}
 			
-				//Time to load a new file slice. 
+		}
+		
+		//Reads until there are k windows in the buffer, or the data runs 
+		//out, and returns them. 
+		WindowBatch<T> batch(unsigned int k) {
 			
-				//Mark as pendingio. 
-				pendingio = true; 
-				
-				function<vector<T>()> fnext = [&](){ return ionext(); }; 
+			if(k == 0 || !fill()) return WindowBatch<T>(nullptr, 0, getwindowsize()); 
 			
-				ft = async(policy, fnext);
-				
+			while(nvalidwindows() < k) {
+				if(pendingio) {
+					read();
+				}
+				else if(!exhausted) {
+					launchnext();
+				}
+				else {
+					break;
+				}
 			}
+			
+			return WindowBatch<T>(data.data() + start, std::min(k, nvalidwindows()), getwindowsize()); 
+			
+		}
+		
+		//Like fill(), but never waits for a load that is still running: true 
+		//once get(), tick() and eods() can be called without blocking, either
+		//because there is a window or because there never will be. A deferred 
+		//load is run here, as there's no other thread to run it. 
+		bool poll() {
+			
+			if(cancelled) return true; 
+			
+			trim(); 
+			
+			while(true) {
+				if(readyio) {
+					read(); 
+				}
+				if(hasvalidwindow()) {
+					return true; 
+				}
+				if(pendingio) {
+					if(ft.wait_for(std::chrono::seconds(0)) == std::future_status::timeout) return false; 
+					read(); 
+				}
+				else if(!exhausted) {
+					launchnext(); 
+				}
+				else {
+					return true; 
+				}
+			}
+			
+		}
+		
+		//If poll() would say false, arrange for callback to be called when the
+		//outstanding load finishes, and return false. Otherwise return true and 
+		//don't call it. The callback runs on the io thread, before the load has
+		//quite handed over its data: it should only schedule the work that 
+		//uses this source (poll() again, then get()) somewhere else. 
+		bool whenready(function<void()> callback) {
+			
+			if(poll()) return true; 
+			
+			std::lock_guard<std::mutex> guard(waitlock); 
+			if(readyio) return true; 
+			waiter = move(callback); 
+			return false; 
+			
 		}
 		
 		inline bool eods() {
@@ -231,9 +590,7 @@ class AsyncIOImpl {
 			
 			//Make sure that we've done all the loading, if there are any 
 			//IO operations pending
-			check();
-			
-			return !hasvalidwindow();
+			return !fill();
 			
 		}
 	
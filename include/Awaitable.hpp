@@ -0,0 +1,103 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+co_await for the asynchronous sources (FileSource, SQLiteSource, 
+MultiFileSource), so one thread can drive thousands of them from coroutines 
+instead of blocking a thread on each. 
+
+	task consume(FileSource<double> & fs, function<void(function<void()>)> post) {
+		while(double * w = co_await awaitwindow(fs, post)) {
+			use(w); 
+			fs.tick(); 
+		}
+	}
+
+awaitwindow() waits for the window the source is at, and gives get(), or 
+nullptr once the data has ended. If the window is already loaded the 
+coroutine carries straight on. If not it is suspended, and when the load 
+finishes the io thread passes its resumption to the executor, a 
+function<void(function<void()>)> that should queue it to run on the event 
+loop; it must not run it there and then. tick() never blocks once the 
+window is there, though it may start the next load. 
+
+This needs C++20 coroutines. Without them the header is empty, and the same 
+thing can be done by hand with poll() and whenready(). The sources should 
+use launch::async: a deferred load can only run on the thread that awaits it.
+
+*/
+
+#ifndef Awaitable_HEADER
+#define Awaitable_HEADER
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+
+#include <coroutine>
+#include <functional>
+#include <utility>
+
+namespace libsim 
+{
+
+template<class Source>
+class WindowAwaitable {
+	
+	private:
+		Source * source; 
+		std::function<void(std::function<void()>)> executor; 
+	
+	public:
+		WindowAwaitable(Source & _source, std::function<void(std::function<void()>)> _executor) : source(&_source), executor(std::move(_executor)) {}
+		
+		bool await_ready() { return source->poll(); }
+		
+		//False, so the coroutine carries on, if the window arrived meanwhile.
+		bool await_suspend(std::coroutine_handle<> handle) {
+			auto post = executor; 
+			return !source->whenready([handle, post]() { post([handle]() { handle.resume(); }); }); 
+		}
+		
+		auto await_resume() -> decltype(source->get()) {
+			if(source->eods()) return nullptr; 
+			return source->get(); 
+		}
+		
+};
+
+template<class Source>
+WindowAwaitable<Source> awaitwindow(Source & source, std::function<void(std::function<void()>)> executor) {
+	return WindowAwaitable<Source>(source, std::move(executor)); 
+}
+
+}
+
+#endif
+#endif
+
+#endif
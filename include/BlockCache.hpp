@@ -0,0 +1,167 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+A process-wide, size-bounded LRU cache of parsed blocks, shared by every 
+RandomAccessSource. Blocks are keyed by a string that identifies the data 
+and how it was cut into blocks, so sources over the same data with the same 
+geometry share blocks. Blocks are handed out as shared_ptrs to const vectors: 
+evicting a block only drops the cache's reference, so anyone still using it 
+keeps it alive. 
+
+*/
+
+#ifndef BlockCache_HEADER
+#define BlockCache_HEADER
+
+#include <list>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstddef>
+
+using std::list;
+using std::string;
+using std::vector;
+using std::shared_ptr;
+using std::static_pointer_cast;
+using std::mutex;
+using std::lock_guard;
+using std::unordered_map;
+
+namespace libsim 
+{
+
+class BlockCache {
+	
+	private:
+		struct Entry {
+			string key; 
+			shared_ptr<void> block; 
+			size_t bytes; 
+		};
+		
+		mutable mutex lock; 
+		
+		//Most recently used at the front. 
+		list<Entry> entries; 
+		unordered_map<string, list<Entry>::iterator> index; 
+		
+		size_t capacity; 
+		size_t usage; 
+		unsigned long hits; 
+		unsigned long misses; 
+		
+		BlockCache() : entries(), index(), capacity(64 * 1024 * 1024), usage(0), hits(0), misses(0) {}
+		
+		inline void trim() {
+			//Always keep the block we've just been asked for. 
+			while(usage > capacity && entries.size() > 1) {
+				usage -= entries.back().bytes; 
+				index.erase(entries.back().key); 
+				entries.pop_back(); 
+			}
+		}
+		
+	public:
+		BlockCache(BlockCache const & cpy) = delete; 
+		BlockCache& operator =(const BlockCache& cpy) = delete; 
+		
+		static BlockCache & instance() {
+			static BlockCache cache; 
+			return cache; 
+		}
+		
+		//Returns an empty pointer on a miss. 
+		template<class T>
+		shared_ptr<const vector<T>> find(const string & key) {
+			lock_guard<mutex> guard(lock); 
+			auto it = index.find(key); 
+			if(it == index.end()) {
+				misses++; 
+				return shared_ptr<const vector<T>>(); 
+			}
+			hits++; 
+			entries.splice(entries.begin(), entries, it->second); 
+			return static_pointer_cast<const vector<T>>(it->second->block); 
+		}
+		
+		//Without counting a hit or a miss, or touching the LRU order. 
+		bool contains(const string & key) const {
+			lock_guard<mutex> guard(lock); 
+			return index.find(key) != index.end(); 
+		}
+		
+		template<class T>
+		void insert(const string & key, shared_ptr<const vector<T>> block) {
+			lock_guard<mutex> guard(lock); 
+			
+			auto it = index.find(key); 
+			if(it != index.end()) {
+				usage -= it->second->bytes; 
+				entries.erase(it->second); 
+				index.erase(it); 
+			}
+			
+			Entry entry; 
+			entry.key = key; 
+			entry.block = static_pointer_cast<void>(std::const_pointer_cast<vector<T>>(block)); 
+			entry.bytes = block->capacity() * sizeof(T); 
+			
+			entries.push_front(entry); 
+			index[key] = entries.begin(); 
+			usage += entry.bytes; 
+			
+			trim(); 
+		}
+		
+		void setcapacity(size_t bytes) {
+			lock_guard<mutex> guard(lock); 
+			capacity = bytes; 
+			trim(); 
+		}
+		
+		void clear() {
+			lock_guard<mutex> guard(lock); 
+			entries.clear(); 
+			index.clear(); 
+			usage = 0; 
+		}
+		
+		inline size_t getcapacity() const { lock_guard<mutex> guard(lock); return capacity; }
+		inline size_t getusage() const { lock_guard<mutex> guard(lock); return usage; }
+		inline unsigned long gethits() const { lock_guard<mutex> guard(lock); return hits; }
+		inline unsigned long getmisses() const { lock_guard<mutex> guard(lock); return misses; }
+		
+};
+
+}
+
+#endif
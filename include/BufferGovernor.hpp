@@ -0,0 +1,236 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+Every AsyncIOImpl sizes its own buffer, which is fine for one source and 
+unpredictable for hundreds. The governor is a process-wide account of the 
+memory the async sources hold. Each source enrolls when it is created, reports 
+what it holds whenever it picks up a load, and asks for permission before it 
+launches the next one. 
+
+The budget is shared between the sources that have been active recently. A 
+source is always allowed a fair share of the budget, and may use more while 
+the rest is unclaimed. Sources that have been idle for longer than the idle 
+timeout don't count towards the share. Whenever the budget is exceeded, every
+source holding more than its share, idle or not, is asked to trim: it gives 
+back what it can the next time it is used, without waiting for its next 
+load. Every source is still allowed a windowsize of progress, so the total is
+bounded by the budget plus roughly one window per source. 
+
+By default the budget is unlimited, and the governor only keeps the books. 
+
+*/
+
+#ifndef BufferGovernor_HEADER
+#define BufferGovernor_HEADER
+
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <limits>
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+
+using std::map;
+using std::mutex;
+using std::lock_guard;
+using std::numeric_limits;
+
+namespace libsim 
+{
+
+class BufferGovernor {
+	
+	private:
+		typedef std::chrono::steady_clock clock; 
+	
+		struct Account {
+			size_t held; 
+			clock::time_point lastactive; 
+			bool trim; 
+		};
+		
+		mutable mutex lock; 
+		map<unsigned long, Account> accounts; 
+		unsigned long nextid; 
+		
+		size_t budget; 
+		size_t usage; 
+		double idletimeout; 
+		
+		//Bumped whenever a trim is asked for, so that sources can see that 
+		//there might be one for them without taking the lock. 
+		std::atomic<unsigned long> trims; 
+		
+		BufferGovernor() : 
+			accounts(), 
+			nextid(0), 
+			budget(numeric_limits<size_t>::max()), 
+			usage(0), 
+			idletimeout(1.0), 
+			trims(0) 
+		{}
+		
+		inline void sethelding(Account & acc, size_t held) {
+			usage -= acc.held; 
+			acc.held = held; 
+			usage += held; 
+			acc.lastactive = clock::now(); 
+		}
+		
+		//The fair share of the budget for each recently active source. 
+		inline size_t share() const {
+			
+			auto now = clock::now(); 
+			size_t active = 0; 
+			
+			for(auto & it : accounts) {
+				if(std::chrono::duration<double>(now - it.second.lastactive).count() <= idletimeout) active++;
+			}
+			
+			return budget / std::max(active, (size_t) 1); 
+			
+		}
+		
+		//Over budget, ask everyone holding more than their share to trim. 
+		inline void reclaim() {
+			
+			if(usage <= budget) return; 
+			
+			size_t fair = share(); 
+			bool asked = false; 
+			
+			for(auto & it : accounts) {
+				if(it.second.held > fair && !it.second.trim) {
+					it.second.trim = true; 
+					asked = true; 
+				}
+			}
+			
+			if(asked) trims.fetch_add(1, std::memory_order_release); 
+			
+		}
+		
+	public:
+		BufferGovernor(BufferGovernor const & cpy) = delete; 
+		BufferGovernor& operator =(const BufferGovernor& cpy) = delete; 
+		
+		static BufferGovernor & instance() {
+			static BufferGovernor governor; 
+			return governor; 
+		}
+		
+		unsigned long enroll() {
+			lock_guard<mutex> guard(lock); 
+			Account acc; 
+			acc.held = 0; 
+			acc.lastactive = clock::now(); 
+			acc.trim = false; 
+			accounts[nextid] = acc; 
+			return nextid++; 
+		}
+		
+		void withdraw(unsigned long id) {
+			lock_guard<mutex> guard(lock); 
+			auto it = accounts.find(id); 
+			if(it == accounts.end()) return; 
+			usage -= it->second.held; 
+			accounts.erase(it); 
+		}
+		
+		//Record what a source holds now. Returns true if it holds more than 
+		//its share while the budget is exceeded, in which case it should trim. 
+		bool update(unsigned long id, size_t held) {
+			lock_guard<mutex> guard(lock); 
+			auto it = accounts.find(id); 
+			if(it == accounts.end()) return false; 
+			sethelding(it->second, held); 
+			reclaim(); 
+			bool trim = it->second.trim; 
+			it->second.trim = false; 
+			return trim; 
+		}
+		
+		//True, once, if the source has been asked to trim since it last 
+		//looked. Cheap to call while gettrims() hasn't moved. 
+		bool trimrequested(unsigned long id) {
+			lock_guard<mutex> guard(lock); 
+			auto it = accounts.find(id); 
+			if(it == accounts.end()) return false; 
+			bool trim = it->second.trim; 
+			it->second.trim = false; 
+			return trim; 
+		}
+		
+		inline unsigned long gettrims() const { return trims.load(std::memory_order_acquire); }
+		
+		//A source holding held bytes would like to load wanted more. Returns the
+		//number of bytes it may load, which is counted against it until its 
+		//next update(). 
+		size_t request(unsigned long id, size_t held, size_t wanted) {
+			lock_guard<mutex> guard(lock); 
+			auto it = accounts.find(id); 
+			if(it == accounts.end()) return wanted; 
+			
+			sethelding(it->second, held); 
+			
+			//A source can always have its share, and more while nobody else 
+			//is using the budget. 
+			size_t free = (budget > usage) ? budget - usage : 0; 
+			size_t limit = std::max(share(), held + free); 
+			
+			size_t granted = (limit > held) ? std::min(wanted, limit - held) : 0; 
+			
+			sethelding(it->second, held + granted); 
+			reclaim(); 
+			
+			return granted; 
+		}
+		
+		void setbudget(size_t bytes) {
+			lock_guard<mutex> guard(lock); 
+			budget = bytes; 
+		}
+		
+		//Seconds without a read after which a source no longer counts towards
+		//the share of the budget. 
+		void setidletimeout(double seconds) {
+			lock_guard<mutex> guard(lock); 
+			idletimeout = seconds; 
+		}
+		
+		inline size_t getbudget() const { lock_guard<mutex> guard(lock); return budget; }
+		inline size_t getusage() const { lock_guard<mutex> guard(lock); return usage; }
+		inline size_t getsources() const { lock_guard<mutex> guard(lock); return accounts.size(); }
+		
+};
+
+}
+
+#endif
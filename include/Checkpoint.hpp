@@ -0,0 +1,157 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+A compact, versioned record of where a source's window is, so that a job can 
+restart from where it was rather than ticking forward from the beginning. 
+
+index is the element the window starts at. For sources that read text, offset 
+is the byte offset of an earlier line whose index is base, and segment is the 
+file it is in; restoring seeks there and skips index - base lines, which is 
+never more than one read. 
+
+On disk it is 40 bytes, little-endian: magic, version, kind, windowsize, 
+segment, index, base, offset. 
+
+*/
+
+#ifndef Checkpoint_HEADER
+#define Checkpoint_HEADER
+
+#include <istream>
+#include <ostream>
+#include <exception>
+#include <cstdint>
+
+using std::istream;
+using std::ostream;
+using std::exception; 
+
+namespace libsim 
+{
+
+class CheckpointInvalidException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "checkpoint is unreadable, or is for a different source";
+	}
+	
+};
+
+class CheckpointUnsupportedException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "this source can't be checkpointed";
+	}
+	
+};
+
+enum class CheckpointKind : uint16_t { 
+	memory = 1, 
+	ring = 2, 
+	file = 3, 
+	multifile = 4, 
+	sqlite = 5, 
+	randomaccess = 6 
+};
+
+class SourceCheckpoint {
+	
+	private:
+		static const uint32_t MAGIC = 0x43575350; 
+		static const uint16_t VERSION = 1; 
+		
+		template<class U>
+		static void put(ostream & out, U value) {
+			for(unsigned int i = 0; i < sizeof(U); i++) {
+				out.put((char) ((value >> (8 * i)) & 0xff)); 
+			}
+		}
+		
+		template<class U>
+		static U take(istream & in) {
+			U value = 0; 
+			for(unsigned int i = 0; i < sizeof(U); i++) {
+				int c = in.get(); 
+				if(c == std::char_traits<char>::eof()) throw CheckpointInvalidException(); 
+				value |= ((U) (unsigned char) c) << (8 * i); 
+			}
+			return value; 
+		}
+	
+	public:
+		CheckpointKind kind; 
+		uint32_t windowsize; 
+		uint32_t segment; 
+		uint64_t index; 
+		uint64_t base; 
+		uint64_t offset; 
+		
+		SourceCheckpoint(CheckpointKind _kind, uint32_t _windowsize, uint64_t _index) : 
+			kind(_kind), windowsize(_windowsize), segment(0), index(_index), base(_index), offset(0) {}
+		
+		void write(ostream & out) const {
+			put<uint32_t>(out, MAGIC); 
+			put<uint16_t>(out, VERSION); 
+			put<uint16_t>(out, (uint16_t) kind); 
+			put<uint32_t>(out, windowsize); 
+			put<uint32_t>(out, segment); 
+			put<uint64_t>(out, index); 
+			put<uint64_t>(out, base); 
+			put<uint64_t>(out, offset); 
+		}
+		
+		static SourceCheckpoint read(istream & in) {
+			
+			if(take<uint32_t>(in) != MAGIC) throw CheckpointInvalidException(); 
+			if(take<uint16_t>(in) != VERSION) throw CheckpointInvalidException(); 
+			
+			CheckpointKind kind = (CheckpointKind) take<uint16_t>(in); 
+			uint32_t windowsize = take<uint32_t>(in); 
+			
+			SourceCheckpoint cp(kind, windowsize, 0); 
+			cp.segment = take<uint32_t>(in); 
+			cp.index = take<uint64_t>(in); 
+			cp.base = take<uint64_t>(in); 
+			cp.offset = take<uint64_t>(in); 
+			
+			return cp; 
+			
+		}
+		
+		//Throws unless this was taken from the same kind of source with the same
+		//windowsize. 
+		inline void expect(CheckpointKind _kind, uint32_t _windowsize) const {
+			if(kind != _kind || windowsize != _windowsize) throw CheckpointInvalidException(); 
+		}
+		
+};
+
+}
+
+#endif
@@ -0,0 +1,320 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* 
+A source that holds its data compressed, in blocks that are decompressed as 
+the window reaches them (see DecodedSource.hpp). It suits counters and 
+slowly changing telemetry, which a VectorSource or SharedSource would store at
+full width. 
+
+Integers are stored as the difference between successive differences, 
+zigzagged so that small negative numbers are small, in base-128 varints: a 
+counter that goes up by about the same amount each time costs about a byte an
+element. Floating point values are stored as in Gorilla (Pelkonen et al., 
+VLDB 2015): each is XORed with the one before, and only the bits that differ 
+are written, reusing the previous run of leading and trailing zeros when the 
+new bits fit inside it, so an unchanged value costs one bit. Both are 
+lossless. 
+
+Each block starts from a raw value and byte aligned, and an index records 
+where each block begins, so any block can be decompressed without the ones 
+before it. getratio() gives the compression achieved. 
+
+	auto cs = CompressedSource<double>(telemetry, 64); 
+*/
+
+#ifndef CompressedSource_HEADER
+#define CompressedSource_HEADER
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+#include "DecodedSource.hpp"
+
+using std::vector;
+using std::size_t; 
+
+namespace libsim 
+{
+
+template<class T>
+class CompressedCodec {
+	
+	static_assert((std::is_integral<T>::value && sizeof(T) <= 8) || (std::is_floating_point<T>::value && (sizeof(T) == 4 || sizeof(T) == 8)), 
+		"T must be an integer of up to 64 bits, float or double");
+	
+	private:
+		//The bits of a float or double, as an unsigned integer. 
+		typedef typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type Bits; 
+		static const unsigned int WIDTH = 8 * sizeof(Bits); 
+		
+		vector<uint8_t> stream; 
+		vector<size_t> index; 
+		size_t count; 
+		size_t blockelements; 
+		
+		//Bits are written most significant first; a block starts a new byte.
+		class BitWriter {
+			
+			private:
+				vector<uint8_t> & out; 
+				unsigned int used; 
+			
+			public:
+				BitWriter(vector<uint8_t> & _out) : out(_out), used(8) {}
+				
+				inline void write(uint64_t value, unsigned int n) {
+					while(n > 0) {
+						if(used == 8) { out.push_back(0); used = 0; }
+						unsigned int take = std::min(n, 8 - used); 
+						uint8_t chunk = (uint8_t) ((value >> (n - take)) & ((1u << take) - 1)); 
+						out.back() |= chunk << (8 - used - take); 
+						used += take; 
+						n -= take; 
+					}
+				}
+				
+		};
+		
+		class BitReader {
+			
+			private:
+				const uint8_t * in; 
+				unsigned int used; 
+			
+			public:
+				BitReader(const uint8_t * _in) : in(_in), used(0) {}
+				
+				inline uint64_t read(unsigned int n) {
+					uint64_t value = 0; 
+					while(n > 0) {
+						unsigned int take = std::min(n, 8 - used); 
+						value = (value << take) | ((*in >> (8 - used - take)) & ((1u << take) - 1)); 
+						used += take; 
+						n -= take; 
+						if(used == 8) { in++; used = 0; }
+					}
+					return value; 
+				}
+				
+		};
+		
+		static inline uint64_t zigzag(uint64_t v) { return (v << 1) ^ (uint64_t) ((int64_t) v >> 63); }
+		static inline uint64_t unzigzag(uint64_t v) { return (v >> 1) ^ (~(v & 1) + 1); }
+		
+		inline void putvarint(uint64_t v) {
+			while(v >= 0x80) {
+				stream.push_back((uint8_t) (v | 0x80)); 
+				v >>= 7; 
+			}
+			stream.push_back((uint8_t) v); 
+		}
+		
+		static inline uint64_t getvarint(const uint8_t * & in) {
+			uint64_t v = 0; 
+			for(unsigned int shift = 0; ; shift += 7) {
+				uint8_t byte = *in++; 
+				v |= (uint64_t) (byte & 0x7f) << shift; 
+				if(byte < 0x80) return v; 
+			}
+		}
+		
+		static inline Bits tobits(T value) { Bits b; std::memcpy(&b, &value, sizeof(T)); return b; }
+		static inline T frombits(Bits b) { T value; std::memcpy(&value, &b, sizeof(T)); return value; }
+		
+		static inline unsigned int leading(Bits v) {
+			unsigned int n = 0; 
+			for(Bits mask = (Bits) 1 << (WIDTH - 1); !(v & mask); mask >>= 1) n++; 
+			return n; 
+		}
+		
+		static inline unsigned int trailing(Bits v) {
+			unsigned int n = 0; 
+			for(; !(v & 1); v >>= 1) n++; 
+			return n; 
+		}
+		
+		//Delta of delta, for integers. All the arithmetic wraps, as unsigned.
+		void encodeblock(const T * values, size_t n, std::true_type) {
+			
+			uint64_t previous = (uint64_t) values[0]; 
+			uint64_t delta = 0; 
+			
+			putvarint(zigzag(previous)); 
+			
+			for(size_t i = 1; i < n; i++) {
+				uint64_t current = (uint64_t) values[i]; 
+				uint64_t d = current - previous; 
+				putvarint(zigzag(d - delta)); 
+				delta = d; 
+				previous = current; 
+			}
+			
+		}
+		
+		size_t decodeblock(const uint8_t * in, size_t n, T * out, std::true_type) const {
+			
+			uint64_t previous = unzigzag(getvarint(in)); 
+			uint64_t delta = 0; 
+			
+			out[0] = (T) previous; 
+			
+			for(size_t i = 1; i < n; i++) {
+				delta += unzigzag(getvarint(in)); 
+				previous += delta; 
+				out[i] = (T) previous; 
+			}
+			
+			return n; 
+			
+		}
+		
+		//XOR with the previous value, for floating point. 
+		void encodeblock(const T * values, size_t n, std::false_type) {
+			
+			BitWriter bits(stream); 
+			
+			Bits previous = tobits(values[0]); 
+			bits.write(previous, WIDTH); 
+			
+			//No window of meaningful bits yet. 
+			unsigned int lead = WIDTH + 1; 
+			unsigned int trail = 0; 
+			
+			for(size_t i = 1; i < n; i++) {
+				
+				Bits current = tobits(values[i]); 
+				Bits x = current ^ previous; 
+				previous = current; 
+				
+				if(x == 0) {
+					bits.write(0, 1); 
+					continue; 
+				}
+				
+				unsigned int l = leading(x); 
+				unsigned int t = trailing(x); 
+				
+				if(lead <= WIDTH && l >= lead && t >= trail) {
+					bits.write(2, 2); 
+					bits.write(x >> trail, WIDTH - lead - trail); 
+				}
+				else {
+					lead = l; 
+					trail = t; 
+					bits.write(3, 2); 
+					bits.write(lead, 6); 
+					bits.write(WIDTH - lead - trail - 1, 6); 
+					bits.write(x >> trail, WIDTH - lead - trail); 
+				}
+				
+			}
+			
+		}
+		
+		size_t decodeblock(const uint8_t * in, size_t n, T * out, std::false_type) const {
+			
+			BitReader bits(in); 
+			
+			Bits previous = (Bits) bits.read(WIDTH); 
+			out[0] = frombits(previous); 
+			
+			unsigned int lead = 0; 
+			unsigned int trail = 0; 
+			
+			for(size_t i = 1; i < n; i++) {
+				
+				if(bits.read(1) == 1) {
+					if(bits.read(1) == 1) {
+						lead = (unsigned int) bits.read(6); 
+						trail = WIDTH - lead - (unsigned int) bits.read(6) - 1; 
+					}
+					previous ^= (Bits) bits.read(WIDTH - lead - trail) << trail; 
+				}
+				
+				out[i] = frombits(previous); 
+				
+			}
+			
+			return n; 
+			
+		}
+		
+		void encode(const T * values, size_t n) {
+			
+			for(size_t from = 0; from < n; from += blockelements) {
+				index.push_back(stream.size()); 
+				encodeblock(values + from, std::min(blockelements, n - from), std::is_integral<T>()); 
+			}
+			
+			stream.shrink_to_fit(); 
+			
+		}
+		
+	public:
+		CompressedCodec(const vector<T> & values, unsigned int _blocksize = 512) : stream(), index(), count(values.size()), blockelements(std::max(_blocksize, 1u)) {
+			encode(values.data(), values.size()); 
+		}
+		
+		CompressedCodec(const T * values, size_t _count, unsigned int _blocksize = 512) : stream(), index(), count(_count), blockelements(std::max(_blocksize, 1u)) {
+			encode(values, _count); 
+		}
+		
+		CompressedCodec(CompressedCodec<T> const & cpy) = delete; 
+		CompressedCodec<T>& operator =(const CompressedCodec<T>& cpy) = delete; 
+		
+		CompressedCodec(CompressedCodec<T> && mv) = default; 
+		CompressedCodec<T>& operator =(CompressedCodec<T> && mv) = default; 
+		~CompressedCodec() = default; 
+		
+		inline size_t size() const { return count; }
+		inline size_t blocksize() const { return blockelements; }
+		inline size_t blocks() const { return index.size(); }
+		inline size_t bytes() const { return stream.size() + index.size() * sizeof(size_t); }
+		
+		inline size_t decode(size_t block, T * out) const {
+			size_t n = std::min(blockelements, count - block * blockelements); 
+			return decodeblock(stream.data() + index[block], n, out, std::is_integral<T>()); 
+		}
+		
+		//how many times smaller than the raw data
+		inline double getratio() const { 
+			return (bytes() == 0) ? 1.0 : (double) (count * sizeof(T)) / bytes(); 
+		}
+		
+};
+
+template<class T, unsigned int N = 0>
+using CompressedSource = DecodedSource<T, CompressedCodec<T>, N>; 
+
+}
+
+#endif
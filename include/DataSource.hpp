@@ -29,11 +29,104 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef DataSource_HEADER
 #define DataSource_HEADER
 
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <exception>
+
+#include "Checkpoint.hpp"
+
+using std::array;
+using std::vector;
+using std::copy;
+using std::exception;
+
 namespace libsim 
 {
 
+class WindowSizeMismatchException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "windowsize does not match the compile-time windowsize";
+	}
+	
+};
+
+//A view of a window whose width is fixed at compile time. It has the same 
+//data()/size()/begin()/end() shape as a std::array, so loops over it can be 
+//unrolled to the exact width.
+template<class T, unsigned int N>
+class Window {
+	
+	private:
+		T * ptr;
+	
+	public:
+		explicit Window(T * _ptr) : ptr(_ptr) {}
+		
+		inline T * data() const { return ptr; }
+		inline T * begin() const { return ptr; }
+		inline T * end() const { return ptr + N; }
+		inline T & operator[](unsigned int i) const { return ptr[i]; }
+		static constexpr unsigned int size() { return N; }
+		
+		inline array<T, N> toarray() const { 
+			array<T, N> tmp;
+			copy(ptr, ptr + N, tmp.begin());
+			return tmp;
+		}
+		
+};
+
+//Consecutive windows as the rows of one matrix. Each window starts one element
+//after the last, so row r is just data() + r and the whole batch covers 
+//rows() + cols() - 1 elements of the source's buffer, with nothing copied. 
+//
+//The row stride is 1, which is less than the row length: loops and libraries
+//that take an arbitrary stride can use the view directly, but GSL matrices 
+//and BLAS insist that the stride (tda, lda) is at least cols(), so pack() the
+//batch into a dense rows() x cols() matrix for them. 
 template<class T>
-class DataSource {
+class WindowBatch {
+	
+	private:
+		T * ptr; 
+		unsigned int nrows; 
+		unsigned int ncols; 
+	
+	public:
+		WindowBatch(T * _ptr, unsigned int _rows, unsigned int _cols) : ptr(_ptr), nrows(_rows), ncols(_cols) {}
+		
+		inline T * data() const { return ptr; }
+		inline unsigned int rows() const { return nrows; }
+		inline unsigned int cols() const { return ncols; }
+		static constexpr unsigned int stride() { return 1; }
+		
+		inline T * row(unsigned int r) const { return ptr + r; }
+		inline T & operator()(unsigned int r, unsigned int c) const { return ptr[r + c]; }
+		
+		//Copies the batch into out, row-major with a stride of cols(). 
+		inline void pack(T * out) const {
+			for(unsigned int r = 0; r < nrows; r++) {
+				copy(ptr + r, ptr + r + ncols, out + (size_t) r * ncols); 
+			}
+		}
+		
+		inline vector<T> pack() const {
+			vector<T> tmp((size_t) nrows * ncols); 
+			pack(tmp.data()); 
+			return tmp; 
+		}
+		
+};
+
+//N == 0 is the runtime-sized DataSource; any other N fixes the windowsize 
+//at compile time. 
+template<class T, unsigned int N = 0>
+class DataSource;
+
+template<class T>
+class DataSource<T, 0> {
 	
 	protected:
 		const unsigned int windowsize;
@@ -49,10 +142,41 @@ class DataSource {
 		//check that the window is still valid
 		virtual bool eods() = 0; 
 		
+		//up to k windows from here as one matrix; fewer (but at least one, 
+		//unless the data has ended) if that is all the source can give 
+		//contiguously. This doesn't move the window. 
+		virtual WindowBatch<T> batch(unsigned int k) { 
+			if(k == 0 || eods()) return WindowBatch<T>(nullptr, 0, windowsize); 
+			return WindowBatch<T>(get(), 1, windowsize); 
+		}
+		
+		//record where the window is, and put it back there
+		virtual SourceCheckpoint checkpoint() { throw CheckpointUnsupportedException(); }
+		virtual void restore(const SourceCheckpoint &) { throw CheckpointUnsupportedException(); }
+		
 		inline unsigned int getwindowsize() { return windowsize; }
     
 };
 
+//The fixed-size variant is still a DataSource<T>, so it can be passed to 
+//anything that takes the runtime-sized interface. 
+template<class T, unsigned int N>
+class DataSource : public DataSource<T, 0> {
+	
+	public:
+		DataSource(unsigned int _windowsize = N) : DataSource<T, 0>(N) { 
+			if(_windowsize != N) throw WindowSizeMismatchException();
+		};
+		~DataSource() { };
+		
+		//Hides the runtime version, so sources written against DataSource<T, N>
+		//see a constant that the compiler can fold.
+		static constexpr unsigned int getwindowsize() { return N; }
+		
+		inline Window<T, N> window() { return Window<T, N>(this->get()); }
+		
+};
+
 }
 
 #endif
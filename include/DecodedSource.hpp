@@ -0,0 +1,170 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* 
+A source over data that is held in memory in some encoded form, cut into 
+blocks that can each be decoded on their own. Only the blocks under the 
+window are decoded, into a small buffer of a few blocks that is reused for 
+the whole run, so get() still returns a contiguous T * while the full history
+stays encoded. When the window reaches the end of the buffer, the blocks it 
+still covers are moved to the front and only the new ones are decoded, so 
+each block is decoded once on a sequential pass. 
+
+The Codec owns the encoded data and provides size() (in elements), 
+blocksize(), blocks(), bytes() (what the encoded data occupies) and 
+decode(block, out), which writes the elements of one block to out and returns
+how many there were; every block but the last is full. See QuantisedSource.hpp 
+and CompressedSource.hpp. 
+
+The window points into the decode buffer, so writing through it changes 
+nothing but the buffer, and the pointer is only good until the next tick. 
+*/
+
+#ifndef DecodedSource_HEADER
+#define DecodedSource_HEADER
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+
+#include "DataSource.hpp"
+
+using std::vector;
+using std::move; 
+using std::size_t; 
+
+namespace libsim 
+{
+
+template<class T, class Codec, unsigned int N = 0>
+class DecodedSource : public DataSource<T, N> {
+	
+	protected:
+		Codec codec; 
+		vector<T> buffer; 
+		//The element buffer[0] holds, and how many are decoded. 
+		size_t first; 
+		size_t count; 
+		size_t start; 
+		
+		//Enough whole blocks for any window wherever it starts in its first
+		//block, and one more so the refills are a block apart. 
+		inline size_t buffersize() {
+			size_t b = codec.blocksize(); 
+			return ((this->getwindowsize() + 2 * b - 2) / b + 1) * b; 
+		}
+		
+		inline void decode() {
+			
+			size_t b = codec.blocksize(); 
+			size_t first_block = start / b; 
+			
+			if(buffer.size() == 0) buffer.resize(buffersize()); 
+			
+			size_t want = 0; 
+			if(first_block < codec.blocks()) want = std::min(buffer.size() / b, codec.blocks() - first_block); 
+			
+			//Blocks that are already decoded and still wanted. 
+			size_t keep = 0; 
+			if(first_block * b >= first && first_block * b < first + count) {
+				size_t from = first_block * b - first; 
+				keep = count - from; 
+				std::move(buffer.begin() + from, buffer.begin() + count, buffer.begin()); 
+			}
+			
+			first = first_block * b; 
+			count = keep; 
+			
+			for(size_t i = (keep + b - 1) / b; i < want; i++) {
+				count += codec.decode(first_block + i, buffer.data() + i * b); 
+			}
+			
+		}
+		
+	public:
+		DecodedSource(Codec _codec, unsigned int _windowsize) : DataSource<T, N>(_windowsize), codec(move(_codec)), buffer(), first(0), count(0), start(0) {}
+		
+		//Only for a compile-time windowsize
+		DecodedSource(Codec _codec) : DataSource<T, N>(), codec(move(_codec)), buffer(), first(0), count(0), start(0) {}
+		
+		DecodedSource(DecodedSource<T, Codec, N> const & cpy) = delete; 
+		DecodedSource<T, Codec, N>& operator =(const DecodedSource<T, Codec, N>& cpy) = delete; 
+		
+		//Moving is fine, so support rvalue move and move assignment operators.
+		DecodedSource(DecodedSource<T, Codec, N> && mv) : 
+			DataSource<T, N>(mv.windowsize), codec(move(mv.codec)), buffer(move(mv.buffer)), first(mv.first), count(mv.count), start(mv.start) {}
+		DecodedSource<T, Codec, N>& operator =(DecodedSource<T, Codec, N> && mv) { 
+			codec = move(mv.codec); 
+			buffer = move(mv.buffer); 
+			first = mv.first; 
+			count = mv.count; 
+			start = mv.start; 
+			return *this; 
+		}
+		~DecodedSource() = default; 
+		
+		//get a pointer to the start of the window
+		T * get() {
+			if(start < first || start + this->getwindowsize() > first + count) decode(); 
+			return buffer.data() + (start - first); 
+		}
+		
+		//increment the start pointer
+		void tick() { start++; }
+		
+		//The windows that are decoded already. 
+		WindowBatch<T> batch(unsigned int k) { 
+			if(eods()) return WindowBatch<T>(nullptr, 0, this->getwindowsize()); 
+			T * window = get(); 
+			size_t available = first + count - this->getwindowsize() - start + 1; 
+			return WindowBatch<T>(window, std::min((size_t) k, available), this->getwindowsize()); 
+		}
+		
+		SourceCheckpoint checkpoint() { 
+			return SourceCheckpoint(CheckpointKind::memory, this->getwindowsize(), start); 
+		}
+		
+		void restore(const SourceCheckpoint & cp) { 
+			cp.expect(CheckpointKind::memory, this->getwindowsize()); 
+			start = cp.index; 
+		}
+		
+		//check that the window is still valid
+		bool eods() { return start + this->getwindowsize() > codec.size(); }
+		
+		//the size of the encoded data, and of the data it stands for
+		inline size_t bytes() const { return codec.bytes(); }
+		inline size_t size() const { return codec.size(); }
+		
+		inline const Codec & getcodec() const { return codec; }
+		
+};
+
+}
+
+#endif
@@ -48,6 +48,25 @@ This class provides a mechanism for the asynchronous loading of data from the fi
 and presenting it in a moving-window interface that is compatabile with the 
 DataSource parent class.
 
+In follow mode the file is treated like tail -f: reaching the end of the file 
+means the writer is behind, not that the data has finished. A trailing line 
+without a newline is held back until it is complete, and the io waits on 
+inotify for the file to be appended to, so the window moves on as soon as 
+the data is written rather than on the next poll. A follow-mode source 
+only reaches eods() if it has a datapoint limit, or is cancelled. 
+
+In parallel mode each load reads a large run of bytes, cut at a newline, 
+splits it into one range per thread (each also cut at a newline) and parses 
+the ranges at the same time on a ParsePool, keeping each range's values in 
+its own buffer so they can be put back in order. The run is sized from the 
+bytes per line seen so far, so a load may come back with somewhat more than 
+was asked for. This is for large files where parsing, not the disk, is 
+what holds the window back. 
+
+With the ParseRegistry enabled (see SharedParse.hpp), snapshot-mode sources 
+over the same file share one parse of it, each reading from it at its own 
+pace. 
+
 */
 
 
@@ -55,98 +74,443 @@ DataSource parent class.
 #define FileSource_HEADER
 
 #include <string>
+#include <fstream>
+#include <sstream>
 #include <cmath>
 #include <exception>
 #include <memory>
 #include <algorithm>
 #include <limits>
+#include <deque>
+#include <mutex>
+#include <cerrno>
+#include <cstdint>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
 
 #include "DataSource.hpp"
 #include "AsyncIOImpl.hpp"
+#include "SharedParse.hpp"
 
 using std::string;
 using std::unique_ptr; 
+using std::shared_ptr; 
 using std::ifstream;
 using std::exception; 
 using std::move;
 using std::numeric_limits;
+using std::vector;
+using std::function;
 
 namespace libsim 
 {
+
+class FileSourceFollowException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "unable to watch the file for appends";
+	}
 	
+};
+
+enum class FileSourceMode { snapshot, follow, parallel };
+
+//One value per line. 
 template <class T>
+inline T parsevalue(const string & line) {
+	
+	stringstream ss(line);
+	T temp;
+	ss >> temp; 
+	
+	return temp; 
+	
+}
+	
+//A fixed set of threads that run the jobs of one parallel() call and wait 
+//for them all; the calling thread takes jobs too, so a pool of n threads 
+//has n - 1 of its own. 
+class ParsePool {
+	
+	private:
+		vector<std::thread> threads; 
+		std::mutex lock; 
+		std::condition_variable wake; 
+		std::condition_variable finished; 
+		
+		function<void(unsigned int)> job; 
+		unsigned int jobs; 
+		unsigned int next; 
+		unsigned int done; 
+		bool stopping; 
+		
+		//Runs jobs until there are none left to start. Called with the lock.
+		inline void work(std::unique_lock<std::mutex> & guard) {
+			while(next < jobs) {
+				unsigned int i = next++; 
+				guard.unlock(); 
+				job(i); 
+				guard.lock(); 
+				if(++done == jobs) finished.notify_all(); 
+			}
+		}
+		
+		inline void run() {
+			std::unique_lock<std::mutex> guard(lock); 
+			while(true) {
+				wake.wait(guard, [this]() { return stopping || next < jobs; }); 
+				if(stopping) return; 
+				work(guard); 
+			}
+		}
+	
+	public:
+		ParsePool(unsigned int n) : threads(), lock(), wake(), finished(), job(), jobs(0), next(0), done(0), stopping(false) {
+			for(unsigned int i = 1; i < n; i++) threads.push_back(std::thread(&ParsePool::run, this)); 
+		}
+		
+		ParsePool(ParsePool const & cpy) = delete; 
+		ParsePool& operator =(const ParsePool& cpy) = delete; 
+		
+		~ParsePool() {
+			{
+				std::lock_guard<std::mutex> guard(lock); 
+				stopping = true; 
+			}
+			wake.notify_all(); 
+			for(std::thread & t : threads) t.join(); 
+		}
+		
+		//Calls fn(0) to fn(n - 1), spread over the threads, and returns when 
+		//they have all returned. 
+		void parallel(unsigned int n, function<void(unsigned int)> fn) {
+			std::unique_lock<std::mutex> guard(lock); 
+			job = fn; 
+			jobs = n; 
+			next = 0; 
+			done = 0; 
+			wake.notify_all(); 
+			work(guard); 
+			finished.wait(guard, [this]() { return done == jobs; }); 
+			jobs = 0; 
+			next = 0; 
+		}
+		
+		inline unsigned int size() const { return threads.size() + 1; }
+		
+};
+
+template <class T, unsigned int N = 0>
 class FileSourceImpl;
 	
-template <class T>
-class FileSource : public DataSource<T> {
+template <class T, unsigned int N = 0>
+class FileSource : public DataSource<T, N> {
 	
 	private:
-		unique_ptr<FileSourceImpl<T>> impl;
+		unique_ptr<FileSourceImpl<T, N>> impl;
 	
 	public:
-		FileSource(string _fn, unsigned int _wsize, launch _policy, int _datapoints) : DataSource<T>(_wsize)
+		FileSource(string _fn, unsigned int _wsize, launch _policy, int _datapoints) : DataSource<T, N>(_wsize)
 		{
-			impl = unique_ptr<FileSourceImpl<T>>(new FileSourceImpl<T>(_fn, _wsize, _datapoints));
+			impl = unique_ptr<FileSourceImpl<T, N>>(new FileSourceImpl<T, N>(_fn, _wsize, _policy, _datapoints));
 		}
 		
-		FileSource(string _fn, unsigned int _wsize, int _datapoints) : DataSource<T>(_wsize)
+		FileSource(string _fn, unsigned int _wsize, int _datapoints) : DataSource<T, N>(_wsize)
 		{
-			impl = unique_ptr<FileSourceImpl<T>>(new FileSourceImpl<T>(_fn, _wsize, launch::deferred, _datapoints));
+			impl = unique_ptr<FileSourceImpl<T, N>>(new FileSourceImpl<T, N>(_fn, _wsize, launch::deferred, _datapoints));
 		}
 			
-		FileSource(string _fn, unsigned int _wsize, launch _policy) : DataSource<T>(_wsize)
+		FileSource(string _fn, unsigned int _wsize, launch _policy) : DataSource<T, N>(_wsize)
+		{
+			impl = unique_ptr<FileSourceImpl<T, N>>(new FileSourceImpl<T, N>(_fn, _wsize, _policy, numeric_limits<unsigned int>::max()));
+		}
+		
+		FileSource(string _fn, unsigned int _wsize) : DataSource<T, N>(_wsize)
+		{
+			impl = unique_ptr<FileSourceImpl<T, N>>(new FileSourceImpl<T, N>(_fn, _wsize, launch::deferred, numeric_limits<unsigned int>::max()));
+		}
+		
+		FileSource(string _fn, unsigned int _wsize, launch _policy, FileSourceMode _mode) : DataSource<T, N>(_wsize)
+		{
+			impl = unique_ptr<FileSourceImpl<T, N>>(new FileSourceImpl<T, N>(_fn, _wsize, _policy, numeric_limits<unsigned int>::max(), _mode));
+		}
+		
+		//A follow-mode source with a limit reaches eods() after _datapoints values.
+		FileSource(string _fn, unsigned int _wsize, launch _policy, int _datapoints, FileSourceMode _mode) : DataSource<T, N>(_wsize)
 		{
-			impl = unique_ptr<FileSourceImpl<T>>(new FileSourceImpl<T>(_fn, _wsize, _policy, numeric_limits<unsigned int>::max()));
+			impl = unique_ptr<FileSourceImpl<T, N>>(new FileSourceImpl<T, N>(_fn, _wsize, _policy, _datapoints, _mode));
 		}
 		
-		FileSource(string _fn, unsigned int _wsize) : DataSource<T>(_wsize)
+		//For FileSourceMode::parallel; 0 threads is one per core. 
+		FileSource(string _fn, unsigned int _wsize, launch _policy, FileSourceMode _mode, unsigned int _threads) : DataSource<T, N>(_wsize)
 		{
-			impl = unique_ptr<FileSourceImpl<T>>(new FileSourceImpl<T>(_fn, _wsize, launch::deferred, numeric_limits<unsigned int>::max()));
+			impl = unique_ptr<FileSourceImpl<T, N>>(new FileSourceImpl<T, N>(_fn, _wsize, _policy, numeric_limits<unsigned int>::max(), _mode, _threads));
 		}
 		
 		//No copying. That would leave this object in a horrendous state
 		//and I don't want to figure out how to do it. 
-		FileSource(FileSource<T> const & cpy) = delete; 
-		FileSource<T>& operator =(const FileSource<T>& cpy) = delete; 
+		FileSource(FileSource<T, N> const & cpy) = delete; 
+		FileSource<T, N>& operator =(const FileSource<T, N>& cpy) = delete; 
 	
 		//Moving is fine, so support rvalue move and move assignment operators.
-		FileSource(FileSource<T> && mv) : DataSource<T>(mv.windowsize), impl(move(mv.impl)) {}
-		FileSource<T>& operator =(FileSource<T> && mv) { impl = move(mv.impl); return *this; }
+		FileSource(FileSource<T, N> && mv) : DataSource<T, N>(mv.windowsize), impl(move(mv.impl)) {}
+		FileSource<T, N>& operator =(FileSource<T, N> && mv) { impl = move(mv.impl); return *this; }
 		~FileSource() = default; 
 		
 		inline virtual T * get() override { return impl->get(); };
 		inline virtual void tick() override { impl->tock(); };
 		inline virtual bool eods() override { return impl->eods(); };
+		
+		//Abandon the stream early: outstanding io stops at the next element.
+		inline void cancel() { if(impl) impl->cancel(); };
+		
+		//Bounds, in elements, on the adaptive read size. 
+		inline void setreadbounds(unsigned int _min, unsigned int _max) { impl->setreadbounds(_min, _max); };
+		inline size_t getheld() const { return impl->getheld(); };
+		inline size_t getmarks() { return impl->getmarks(); };
+		
+		//Without blocking: is a window (or the end of the data) here yet? If 
+		//not, whenready() calls back from the io thread when it might be. 
+		inline bool poll() { return impl->poll(); };
+		inline bool whenready(function<void()> callback) { return impl->whenready(move(callback)); };
+		
+		inline virtual WindowBatch<T> batch(unsigned int k) override { return impl->batch(k); };
+		inline virtual SourceCheckpoint checkpoint() override { return impl->checkpoint(); };
+		inline virtual void restore(const SourceCheckpoint & cp) override { impl->restore(cp); };
 
 };
 
-template <class T>
-class FileSourceImpl : public AsyncIOImpl<T> {
+template <class T, unsigned int N>
+class FileSourceImpl : public AsyncIOImpl<T, N> {
 	
 	private:
 		ifstream file;
+		const string filename; 
+		
+		const FileSourceMode mode; 
+		
+		//In follow mode, the part of the last line that has been written so far.
+		string partial; 
+		
+		//inotify watch on the file, and an eventfd that cancel() uses to 
+		//interrupt the wait. 
+		int notifyfd; 
+		int wakefd; 
+		
+		//Where each load started, as (element index, byte offset), so that a 
+		//checkpoint can point at a line near the window. The loads add to 
+		//this and the consumer prunes it, so it is locked. It starts with the
+		//start of the file, so there is a place before the first load is in.
+		struct Mark {
+			unsigned long index; 
+			std::streamoff offset; 
+		};
+		std::deque<Mark> marks; 
+		std::mutex marklock; 
+		
+		//Only in parallel mode. The estimate of bytes per line sizes each read.
+		unique_ptr<ParsePool> pool; 
+		double linebytes; 
+		
+		//Set if we are reading another source's parse of the file rather than
+		//the file: the chunk we're in, how far through it, and our cursor. 
+		shared_ptr<SharedParse<T>> shared; 
+		shared_ptr<ParseChunk<T>> chunk; 
+		size_t within; 
+		unsigned long cursor; 
+		
+		//Stop sharing, letting the parse know before we let go of our chunk.
+		inline void unshare() {
+			if(!shared) return; 
+			shared->leave(cursor); 
+			chunk.reset(); 
+			shared.reset(); 
+		}
+		
+		//We fell too far behind the others: carry on from the end of our 
+		//chunk in the file ourselves. 
+		inline void detach() {
+			
+			file.open(filename); 
+			file.seekg(chunk->offset); 
+			
+			string stemp; 
+			for(size_t skip = chunk->values.size(); skip > 0 && getline(file, stemp); skip--) {} 
+			
+			unshare(); 
+			ParseRegistry::instance().detach(); 
+			
+		}
+		
+		//The last mark at or before the window; anything before that is no 
+		//longer needed. Called with marklock held. 
+		inline void prune() {
+			while(marks.size() > 1 && marks[1].index <= this->position) marks.pop_front(); 
+		}
+		
+		virtual void loaded() override {
+			std::lock_guard<std::mutex> guard(marklock); 
+			prune(); 
+		}
+		
+		inline void mark() {
+			
+			std::streamoff here = file.tellg(); 
+			if(here < 0) return; 
+			
+			Mark m; 
+			m.index = this->datapoints_read; 
+			m.offset = here - partial.size(); 
+			
+			std::lock_guard<std::mutex> guard(marklock); 
+			marks.push_back(m); 
+			
+		}
+		
+		inline void parse(const string & line, vector<T> & tmpdata) {
+			
+			tmpdata.push_back(parsevalue<T>(line));
+			
+			this->datapoints_read++;
+			
+		}
+		
+		//Block until the file has been appended to. Returns false if we were
+		//woken up by a cancel instead. 
+		inline bool waitforappend() {
+			
+#ifdef __linux__
+			struct pollfd fds[2]; 
+			fds[0].fd = notifyfd; 
+			fds[0].events = POLLIN; 
+			fds[1].fd = wakefd; 
+			fds[1].events = POLLIN; 
+			
+			while(poll(fds, 2, -1) < 0) {
+				if(errno != EINTR) return false; 
+			}
+			
+			if(fds[1].revents & POLLIN) return false; 
+			
+			//Drain the events; we only care that something happened. Anything 
+			//appended after this will queue another one. 
+			char events[4096]; 
+			while(::read(notifyfd, events, sizeof(events)) > 0) {} 
+			
+			return true; 
+#else
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			return !this->cancelled; 
+#endif
+			
+		}
 	
-		virtual vector<T> ioinit() override { 
+		//Parse a run of whole lines, as getline would see them, one range per
+		//thread, and append the values in order. 
+		inline void parseparallel(const string & text, vector<T> & tmpdata) {
+			
+			unsigned int ranges = pool->size(); 
+			
+			vector<size_t> bounds(ranges + 1, text.size()); 
+			bounds[0] = 0; 
+			for(unsigned int r = 1; r < ranges; r++) {
+				size_t at = std::max(bounds[r - 1], text.size() * r / ranges); 
+				if(at > 0 && at < text.size()) {
+					size_t nl = text.find('\n', at - 1); 
+					at = (nl == string::npos) ? text.size() : nl + 1; 
+				}
+				bounds[r] = at; 
+			}
+			
+			vector<vector<T>> parsed(ranges); 
+			
+			pool->parallel(ranges, [&text, &bounds, &parsed](unsigned int r) {
+				
+				string line; 
+				size_t at = bounds[r]; 
+				
+				while(at < bounds[r + 1]) {
+					size_t nl = text.find('\n', at); 
+					size_t end = (nl == string::npos || nl > bounds[r + 1]) ? bounds[r + 1] : nl; 
+					line.assign(text, at, end - at); 
+					parsed[r].push_back(parsevalue<T>(line)); 
+					at = end + 1; 
+				}
+				
+			}); 
+			
+			for(vector<T> & values : parsed) {
+				tmpdata.insert(tmpdata.end(), values.begin(), values.end()); 
+			}
+			
+		}
+		
+		inline vector<T> loadparallel() {
 			
 			auto tmpdata = vector<T>();
 			tmpdata.reserve(this->read_extent);
 			
-			unsigned int i = 0;
+			mark(); 
 			
-			for( ; i < this->read_extent; i++)  {
-				if(this->datapoints_read == this->datapoints_limit) break; 
-				if(file.eof()) break;
+			string text; 
+			
+			while(tmpdata.size() < this->read_extent && this->datapoints_read < this->datapoints_limit && !this->cancelled) {
 				
-				string stemp; 
-				getline(file, stemp);
+				size_t remaining = std::min((size_t) (this->read_extent - tmpdata.size()), (size_t) (this->datapoints_limit - this->datapoints_read)); 
+				
+				//Enough bytes for about that many lines, going by the lines so 
+				//far; any more are put back below. 
+				size_t want = std::max((size_t) (remaining * linebytes), (size_t) 1); 
+				std::streamoff from = file.tellg(); 
+				
+				text.resize(want); 
+				file.read(&text[0], want); 
+				text.resize(file.gcount()); 
+				
+				//Finish the line we stopped in. 
+				if(file) {
+					string rest; 
+					if(getline(file, rest)) {
+						text.append(rest); 
+						if(!file.eof()) text.push_back('\n'); 
+					}
+				}
+				
+				if(text.empty()) break; 
 				
-				stringstream ss(stemp);
-				T temp;
-				ss >> temp; 
+				//Keep no more lines than the load was granted, and leave the 
+				//reader at the start of the first one we didn't keep. 
+				size_t end = 0; 
+				for(size_t kept = 0; kept < remaining && end < text.size(); kept++) {
+					size_t nl = text.find('\n', end); 
+					end = (nl == string::npos) ? text.size() : nl + 1; 
+				}
+				if(end < text.size()) {
+					text.resize(end); 
+					file.clear(); 
+					file.seekg(from + (std::streamoff) end); 
+				}
 				
-				tmpdata.push_back(temp);
+				size_t before = tmpdata.size(); 
+				parseparallel(text, tmpdata); 
+				
+				size_t lines = tmpdata.size() - before; 
+				if(lines > 0) linebytes = 0.5 * linebytes + 0.5 * ((double) text.size() / lines); 
+				
+				this->datapoints_read += lines; 
+				
+				if(!file) break; 
 				
-				this->datapoints_read++;
 			}
 			
 			this->readyio = true; 
@@ -154,32 +518,104 @@ class FileSourceImpl : public AsyncIOImpl<T> {
 			return tmpdata;
 			
 		}
-		
-		virtual vector<T> ionext() override {
-		
-			//Create and configure the 
-			//return
+	
+		inline vector<T> loadshared() {
+			
 			auto tmpdata = vector<T>();
-			tmpdata.reserve(this->windowsize);
+			tmpdata.reserve(this->read_extent);
+			
+			//The start of the chunk is a line we can find again. 
+			{
+				Mark m; 
+				m.index = chunk->index; 
+				m.offset = chunk->offset; 
+				
+				std::lock_guard<std::mutex> guard(marklock); 
+				marks.push_back(m); 
+			}
 			
-			//Now the load
+			while(tmpdata.size() < this->read_extent && this->datapoints_read < this->datapoints_limit && !this->cancelled) {
+				
+				if(within == chunk->values.size()) {
+					auto n = shared->next(chunk, cursor); 
+					if(!n) {
+						if(shared->wascut(cursor)) detach(); 
+						break; 
+					}
+					chunk = n; 
+					within = 0; 
+					continue; 
+				}
+				
+				size_t take = std::min(chunk->values.size() - within, (size_t) (this->read_extent - tmpdata.size())); 
+				take = std::min(take, (size_t) (this->datapoints_limit - this->datapoints_read)); 
+				
+				tmpdata.insert(tmpdata.end(), chunk->values.begin() + within, chunk->values.begin() + within + take); 
+				within += take; 
+				this->datapoints_read += take; 
+				
+			}
 			
-			unsigned int i = 0; 
+			//The rest of the load, if we had to go back to the file. 
+			if(!shared) {
+				string stemp; 
+				while(tmpdata.size() < this->read_extent && this->datapoints_read < this->datapoints_limit && !this->cancelled && getline(file, stemp)) {
+					parse(stemp, tmpdata); 
+				}
+			}
+			
+			this->readyio = true; 
+			
+			return tmpdata;
+			
+		}
+	
+		inline vector<T> load() {
+			
+			if(shared) return loadshared(); 
+			//Loads too small to give each thread a useful run of lines are 
+			//parsed here instead. 
+			if(mode == FileSourceMode::parallel && this->read_extent >= pool->size() * 64) return loadparallel(); 
+			
+			auto tmpdata = vector<T>();
+			tmpdata.reserve(this->read_extent);
 			
-			for( ; i < this->windowsize; i++)  {
+			mark(); 
+			
+			while(tmpdata.size() < this->read_extent)  {
 				if(this->datapoints_read == this->datapoints_limit) break; 
-				if(file.eof()) break;
+				if(this->cancelled) break;
+				
+				if(mode == FileSourceMode::follow) {
+					
+					string stemp; 
+					getline(file, stemp);
+					
+					if(!file.eof()) {
+						partial.append(stemp); 
+						parse(partial, tmpdata); 
+						partial.clear(); 
+						continue; 
+					}
+					
+					//We have run into the writer. Hold on to what there is of 
+					//the line, and either hand over what we have now or wait 
+					//for more. 
+					partial.append(stemp); 
+					file.clear(); 
+					
+					if(!tmpdata.empty()) break; 
+					if(!waitforappend()) break; 
+					
+					continue; 
+				}
 				
+				//A trailing newline leaves one last, failing, read; that isn't
+				//a value. 
 				string stemp; 
-				getline(file, stemp);
+				if(!getline(file, stemp)) break;
 				
-				stringstream ss(stemp);
-				T temp;
-				ss >> temp; 
-			
-				tmpdata.push_back(temp);
-
-				this->datapoints_read++;
+				parse(stemp, tmpdata);
 			}
 			
 			this->readyio = true; 
@@ -187,24 +623,142 @@ class FileSourceImpl : public AsyncIOImpl<T> {
 			return tmpdata;
 			
 		}
+		
+		virtual void iowake() override {
+#ifdef __linux__
+			if(wakefd >= 0) {
+				uint64_t one = 1; 
+				ssize_t res = ::write(wakefd, &one, sizeof(one));
+				(void) res; 
+			}
+#endif
+		}
 	
+		virtual vector<T> ioinit() override { return load(); }
+		virtual vector<T> ionext() override { return load(); }
 		
 	public:
-		FileSourceImpl(string filename, unsigned int _wsize, launch _policy, unsigned int datapoints) :
-			AsyncIOImpl<T>(_wsize, _policy, datapoints),
-			file(filename) 
+		FileSourceImpl(string _filename, unsigned int _wsize, launch _policy, unsigned int datapoints, FileSourceMode _mode = FileSourceMode::snapshot, unsigned int threads = 0) :
+			AsyncIOImpl<T, N>(_wsize, _policy, datapoints),
+			file(),
+			filename(_filename),
+			mode(_mode),
+			partial(),
+			notifyfd(-1),
+			wakefd(-1),
+			marks(1, Mark{0, 0}),
+			marklock(),
+			pool(),
+			linebytes(16.0),
+			shared(),
+			chunk(),
+			within(0),
+			cursor(0)
 		{
 			
+			if(mode == FileSourceMode::snapshot) shared = ParseRegistry::instance().attach<T>(filename, datapoints, chunk, cursor); 
+			if(!shared) file.open(filename); 
+			
+			if(mode == FileSourceMode::parallel) {
+				if(threads == 0) threads = std::max(std::thread::hardware_concurrency(), 1u); 
+				pool = unique_ptr<ParsePool>(new ParsePool(threads)); 
+			}
+			
+			if(mode == FileSourceMode::follow) {
+				
+				this->streaming = true; 
+				
+#ifdef __linux__
+				notifyfd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC); 
+				wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC); 
+				
+				if(notifyfd < 0 || wakefd < 0 || inotify_add_watch(notifyfd, filename.c_str(), IN_MODIFY | IN_CLOSE_WRITE) < 0) {
+					if(notifyfd >= 0) close(notifyfd); 
+					if(wakefd >= 0) close(wakefd); 
+					throw FileSourceFollowException(); 
+				}
+#endif
+				
+			}
+			
+			this->prime();
 			
 		}
 		
 		//Absolutely no copying. 
-		FileSourceImpl(FileSourceImpl<T> const & cpy) = delete; 
-		FileSourceImpl<T>& operator =(const FileSourceImpl<T>& cpy) = delete; 
+		FileSourceImpl(FileSourceImpl<T, N> const & cpy) = delete; 
+		FileSourceImpl<T, N>& operator =(const FileSourceImpl<T, N>& cpy) = delete; 
+		
+		FileSourceImpl(FileSourceImpl<T, N> && mv) = delete; 
+		FileSourceImpl<T, N>& operator =(FileSourceImpl<T, N> && mv) = delete; 
+		~FileSourceImpl() {
+			
+			//Stop the io before the file goes away underneath it. 
+			this->cancel();
+			unshare(); 
+			
+#ifdef __linux__
+			if(notifyfd >= 0) close(notifyfd); 
+			if(wakefd >= 0) close(wakefd); 
+#endif
+			
+		}
+		
+		//How many places a checkpoint could go back to are being kept. 
+		size_t getmarks() {
+			std::lock_guard<std::mutex> guard(marklock); 
+			return marks.size(); 
+		}
+		
+		SourceCheckpoint checkpoint() {
+			
+			std::lock_guard<std::mutex> guard(marklock); 
+			
+			prune(); 
+			
+			if(marks.empty() || marks[0].index > this->position) throw CheckpointUnsupportedException(); 
+			
+			SourceCheckpoint cp(CheckpointKind::file, this->getwindowsize(), this->position); 
+			cp.base = marks[0].index; 
+			cp.offset = marks[0].offset; 
+			
+			return cp; 
+			
+		}
 		
-		FileSourceImpl(FileSourceImpl<T> && mv) = delete; 
-		FileSourceImpl<T>& operator =(FileSourceImpl<T> && mv) = delete; 
-		~FileSourceImpl() = default; 
+		void restore(const SourceCheckpoint & cp) {
+			
+			cp.expect(CheckpointKind::file, this->getwindowsize()); 
+			if(cp.base > cp.index) throw CheckpointInvalidException(); 
+			
+			//Find the place on a stream of our own first, so that a checkpoint
+			//that doesn't fit the file leaves this source as it was. 
+			ifstream scratch(filename); 
+			scratch.seekg(cp.offset); 
+			
+			string stemp; 
+			for(unsigned long skip = cp.index - cp.base; skip > 0; skip--) {
+				if(!getline(scratch, stemp)) throw CheckpointInvalidException(); 
+			}
+			if(!scratch) throw CheckpointInvalidException(); 
+			
+			this->settle(); 
+			
+			{
+				std::lock_guard<std::mutex> guard(marklock); 
+				marks.clear(); 
+				marks.push_back(Mark{cp.index, scratch.tellg()}); 
+			}
+			
+			//Back to reading the file ourselves, if we were sharing. 
+			unshare(); 
+			
+			partial.clear(); 
+			file = move(scratch); 
+			
+			this->restart(cp.index); 
+			
+		}
 		
 };
 
@@ -0,0 +1,232 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+A sorted multiset with O(log n) insert, remove and lookup by rank, for order 
+statistics over a sliding window (SlidingQuantile). 
+
+It is a skiplist in which every link also records how many elements it skips,
+so that the element of rank i can be found by walking down the levels the 
+same way a value is, subtracting widths instead of comparing values. The 
+capacity is fixed when it is constructed, and the nodes live in flat arrays 
+indexed by node number, so nothing is allocated after that. 
+
+*/
+
+#ifndef IndexableSkiplist_HEADER
+#define IndexableSkiplist_HEADER
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+
+using std::vector;
+using std::exception; 
+
+namespace libsim 
+{
+
+class IndexableSkiplistInvalidException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "skiplist is full, or doesn't hold that value or rank";
+	}
+	
+};
+
+template<class T>
+class IndexableSkiplist {
+	
+	private:
+		enum : unsigned int { NIL = std::numeric_limits<unsigned int>::max(), HEAD = 0 }; 
+		
+		unsigned int capacity; 
+		unsigned int levels; 
+		unsigned int count; 
+		
+		//Node n's link at level l is at n * levels + l. Node 0 is the head. 
+		vector<T> values; 
+		vector<unsigned int> heights; 
+		vector<unsigned int> next; 
+		vector<unsigned int> width; 
+		vector<unsigned int> freenodes; 
+		
+		//Scratch for insert and remove. 
+		vector<unsigned int> chain; 
+		vector<unsigned int> stepsat; 
+		
+		uint64_t seed; 
+		
+		inline unsigned int & link(unsigned int n, unsigned int l) { return next[n * levels + l]; }
+		inline unsigned int & span(unsigned int n, unsigned int l) { return width[n * levels + l]; }
+		
+		//Each level holds about half the nodes of the one below. 
+		inline unsigned int randomheight() {
+			seed ^= seed << 13; 
+			seed ^= seed >> 7; 
+			seed ^= seed << 17; 
+			unsigned int h = 1; 
+			uint64_t bits = seed; 
+			while(h < levels && (bits & 1)) {
+				h++; 
+				bits >>= 1; 
+			}
+			return h; 
+		}
+	
+	public:
+		IndexableSkiplist(unsigned int _capacity) : 
+			capacity(_capacity), 
+			levels(1), 
+			count(0), 
+			values(), 
+			heights(), 
+			next(), 
+			width(), 
+			freenodes(), 
+			chain(), 
+			stepsat(), 
+			seed(0x9E3779B97F4A7C15ull) 
+		{
+			
+			while(levels < 32 && (1u << levels) < capacity) levels++; 
+			
+			values.resize(capacity + 1); 
+			heights.resize(capacity + 1, 0); 
+			next.resize((size_t) (capacity + 1) * levels, NIL); 
+			width.resize((size_t) (capacity + 1) * levels, 1); 
+			chain.resize(levels); 
+			stepsat.resize(levels); 
+			
+			heights[HEAD] = levels; 
+			
+			freenodes.reserve(capacity); 
+			for(unsigned int n = capacity; n >= 1; n--) freenodes.push_back(n); 
+			
+		}
+		
+		inline unsigned int size() const { return count; }
+		inline unsigned int getcapacity() const { return capacity; }
+		
+		void insert(T value) {
+			
+			if(freenodes.empty()) throw IndexableSkiplistInvalidException(); 
+			
+			//Find where it goes on every level, and how far along that is. 
+			unsigned int node = HEAD, steps = 0; 
+			for(unsigned int l = levels; l-- > 0; ) {
+				while(link(node, l) != NIL && !(value < values[link(node, l)])) {
+					steps += span(node, l); 
+					node = link(node, l); 
+				}
+				chain[l] = node; 
+				stepsat[l] = steps; 
+			}
+			
+			unsigned int n = freenodes.back(); 
+			freenodes.pop_back(); 
+			
+			unsigned int h = randomheight(); 
+			values[n] = value; 
+			heights[n] = h; 
+			
+			for(unsigned int l = 0; l < h; l++) {
+				unsigned int prev = chain[l]; 
+				link(n, l) = link(prev, l); 
+				link(prev, l) = n; 
+				span(n, l) = span(prev, l) - (steps - stepsat[l]); 
+				span(prev, l) = steps - stepsat[l] + 1; 
+			}
+			
+			for(unsigned int l = h; l < levels; l++) span(chain[l], l)++; 
+			
+			count++; 
+			
+		}
+		
+		//Removes one element equal to value. 
+		void remove(T value) {
+			
+			unsigned int node = HEAD; 
+			for(unsigned int l = levels; l-- > 0; ) {
+				while(link(node, l) != NIL && values[link(node, l)] < value) node = link(node, l); 
+				chain[l] = node; 
+			}
+			
+			unsigned int target = link(chain[0], 0); 
+			if(target == NIL || value < values[target] || values[target] < value) throw IndexableSkiplistInvalidException(); 
+			
+			for(unsigned int l = 0; l < heights[target]; l++) {
+				unsigned int prev = chain[l]; 
+				span(prev, l) += span(target, l) - 1; 
+				link(prev, l) = link(target, l); 
+			}
+			
+			for(unsigned int l = heights[target]; l < levels; l++) span(chain[l], l)--; 
+			
+			freenodes.push_back(target); 
+			count--; 
+			
+		}
+		
+		//The element of rank i, counting from 0 for the smallest. 
+		T at(unsigned int i) {
+			
+			if(i >= count) throw IndexableSkiplistInvalidException(); 
+			
+			unsigned int node = HEAD, remaining = i + 1; 
+			for(unsigned int l = levels; l-- > 0; ) {
+				while(link(node, l) != NIL && span(node, l) <= remaining) {
+					remaining -= span(node, l); 
+					node = link(node, l); 
+				}
+			}
+			
+			return values[node]; 
+			
+		}
+		
+		void clear() {
+			
+			std::fill(next.begin(), next.end(), NIL); 
+			std::fill(width.begin(), width.end(), 1); 
+			
+			freenodes.clear(); 
+			for(unsigned int n = capacity; n >= 1; n--) freenodes.push_back(n); 
+			
+			count = 0; 
+			
+		}
+		
+};
+
+}
+
+#endif
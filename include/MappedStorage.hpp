@@ -0,0 +1,154 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+Storage for WindowedSource that maps a file of raw T (as written by 
+fwrite/ofstream::write, in this machine's byte order) into memory instead of 
+reading it. Pages are only read in as the window reaches them, so opening a 
+large file costs nothing up front and only the part in use is resident. 
+
+The mapping is private: writing through the window changes this process's 
+copy of the page, never the file. 
+
+*/
+
+#ifndef MappedStorage_HEADER
+#define MappedStorage_HEADER
+
+#include <string>
+#include <exception>
+#include <cstddef>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "WindowedSource.hpp"
+
+using std::string;
+using std::exception; 
+using std::size_t; 
+
+namespace libsim 
+{
+
+class MappedStorageInvalidException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "file could not be mapped, or is not a whole number of elements";
+	}
+	
+};
+
+template<class T>
+class MappedStorage {
+	
+	private:
+		T * values; 
+		size_t count; 
+		size_t length; 
+	
+	public:
+		MappedStorage(const string & filename) : values(nullptr), count(0), length(0) {
+			
+			int fd = open(filename.c_str(), O_RDONLY); 
+			if(fd < 0) throw MappedStorageInvalidException(); 
+			
+			struct stat st; 
+			if(fstat(fd, &st) != 0 || st.st_size % sizeof(T) != 0) {
+				::close(fd); 
+				throw MappedStorageInvalidException(); 
+			}
+			
+			length = st.st_size; 
+			count = length / sizeof(T); 
+			
+			//mmap won't map nothing, and an empty file needs no memory anyway. 
+			if(length > 0) {
+				
+				void * addr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0); 
+				
+				if(addr == MAP_FAILED) {
+					::close(fd); 
+					throw MappedStorageInvalidException(); 
+				}
+				
+				//The window only ever moves forwards. 
+				madvise(addr, length, MADV_SEQUENTIAL); 
+				values = static_cast<T *>(addr); 
+				
+			}
+			
+			//The mapping keeps the file open. 
+			::close(fd); 
+			
+		}
+		
+		MappedStorage(const char * filename) : MappedStorage(string(filename)) {}
+		
+		//Absolutely no copying. 
+		MappedStorage(MappedStorage<T> const & cpy) = delete; 
+		MappedStorage<T>& operator =(const MappedStorage<T>& cpy) = delete; 
+		
+		MappedStorage(MappedStorage<T> && mv) : values(mv.values), count(mv.count), length(mv.length) {
+			mv.values = nullptr; 
+			mv.count = 0; 
+			mv.length = 0; 
+		}
+		
+		MappedStorage<T>& operator =(MappedStorage<T> && mv) {
+			
+			if(this != &mv) {
+				if(values) munmap(values, length); 
+				values = mv.values; 
+				count = mv.count; 
+				length = mv.length; 
+				mv.values = nullptr; 
+				mv.count = 0; 
+				mv.length = 0; 
+			}
+			
+			return *this; 
+			
+		}
+		
+		~MappedStorage() {
+			if(values) munmap(values, length); 
+		}
+		
+		inline T * data() { return values; }
+		inline size_t size() const { return count; }
+		
+};
+
+template<class T, unsigned int N = 0>
+using MappedSource = WindowedSource<T, MappedStorage<T>, N>; 
+
+}
+
+#endif
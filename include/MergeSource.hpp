@@ -0,0 +1,260 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+Lines up several timestamped inputs (TimedLoaders over files or tables) into 
+windows of rows, where each row is a timestamp and one value per input. The 
+inputs are merged in time order with a heap keyed on each input's next 
+timestamp, so each sample costs O(log N) for N inputs, and each input is 
+prefetched in the background on its own. 
+
+How the rows are made is up to the MergeAlignment: 
+
+	asof: a row at every timestamp in any input, holding the latest value 
+	of each input at or before it. Rows start once every input has a value. 
+	
+	exact: a row only at timestamps present in every input. 
+	
+	interpolated: a row at every timestamp in any input; inputs without a 
+	sample at that time are interpolated linearly between their samples 
+	either side. Rows start once every input has started and stop when the 
+	first input runs out. 
+
+The rows are held column by column: get(c) is a contiguous array of the 
+windowsize values of input c in the window, and times() the timestamps. 
+
+*/
+
+#ifndef MergeSource_HEADER
+#define MergeSource_HEADER
+
+#include <vector>
+#include <queue>
+#include <memory>
+#include <utility>
+#include <functional>
+#include <algorithm>
+#include <exception>
+
+#include "TimeWindowSource.hpp"
+#include "TimedStream.hpp"
+
+using std::vector;
+using std::priority_queue;
+using std::pair;
+using std::unique_ptr;
+using std::move;
+using std::exception; 
+
+namespace libsim 
+{
+
+class MergeSourceInvalidException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "merge needs at least one input, and has no window once they are exhausted";
+	}
+	
+};
+
+enum class MergeAlignment { asof, exact, interpolated };
+
+template<class T>
+class MergeSource {
+	
+	private:
+		typedef pair<double, unsigned int> Entry; 
+	
+		vector<TimedStream<T>> inputs; 
+		const unsigned int windowsize; 
+		const MergeAlignment alignment; 
+		
+		//The next sample of each input that has one, earliest first. 
+		priority_queue<Entry, vector<Entry>, std::greater<Entry>> heap; 
+		
+		//The latest sample of each input, and whether there has been one. 
+		vector<double> lasttime; 
+		vector<T> lastvalue; 
+		vector<bool> started; 
+		vector<bool> present; 
+		vector<T> row; 
+		
+		//The rows, column by column. 
+		vector<double> timestamps; 
+		vector<vector<T>> columns; 
+		unsigned int start; 
+		bool finished; 
+		
+		inline void push(unsigned int c) {
+			if(inputs[c].more()) heap.push(Entry(inputs[c].time(), c)); 
+		}
+		
+		//The value of input c at time t, if it can be had. 
+		inline bool valueat(unsigned int c, double t, T & v) {
+			
+			if(!started[c]) return false; 
+			
+			if(present[c] || alignment == MergeAlignment::asof) {
+				v = lastvalue[c]; 
+				return true; 
+			}
+			
+			if(!inputs[c].more()) return false; 
+			
+			double t0 = lasttime[c], t1 = inputs[c].time(); 
+			T v0 = lastvalue[c], v1 = inputs[c].value(); 
+			
+			//In double, so that unsigned values can go down. 
+			v = (t1 == t0) ? v0 : (T) ((double) v0 + ((double) v1 - (double) v0) * ((t - t0) / (t1 - t0))); 
+			return true; 
+			
+		}
+		
+		//Take every sample at the next timestamp, and make a row of them if 
+		//the alignment allows. False once the inputs are done. 
+		inline bool step() {
+			
+			if(heap.empty()) return false; 
+			
+			double t = heap.top().first; 
+			std::fill(present.begin(), present.end(), false); 
+			unsigned int count = 0; 
+			
+			while(!heap.empty() && heap.top().first == t) {
+				
+				unsigned int c = heap.top().second; 
+				heap.pop(); 
+				
+				lasttime[c] = t; 
+				lastvalue[c] = inputs[c].value(); 
+				started[c] = true; 
+				if(!present[c]) count++; 
+				present[c] = true; 
+				
+				inputs[c].pop(); 
+				push(c); 
+				
+			}
+			
+			if(alignment == MergeAlignment::exact && count < inputs.size()) return true; 
+			
+			for(unsigned int c = 0; c < inputs.size(); c++) {
+				if(!valueat(c, t, row[c])) {
+					//c has run out, so nothing after this can be interpolated. 
+					if(started[c]) heap = decltype(heap)(); 
+					return true; 
+				}
+			}
+			
+			timestamps.push_back(t); 
+			for(unsigned int c = 0; c < inputs.size(); c++) columns[c].push_back(row[c]); 
+			
+			return true; 
+			
+		}
+		
+		inline bool hasvalidwindow() const {
+			return timestamps.size() >= start + windowsize; 
+		}
+		
+		inline bool fill() {
+			
+			if(hasvalidwindow()) return true; 
+			
+			//remove past rows (start can be past the end, if we were ticked
+			//while there was no window) 
+			unsigned int drop = std::min<size_t>(start, timestamps.size()); 
+			timestamps.erase(timestamps.begin(), timestamps.begin() + drop); 
+			for(auto & column : columns) column.erase(column.begin(), column.begin() + drop); 
+			start -= drop; 
+			
+			while(!hasvalidwindow() && !finished) {
+				if(!step()) finished = true; 
+			}
+			
+			return hasvalidwindow(); 
+			
+		}
+	
+	public:
+		MergeSource(vector<unique_ptr<TimedLoader<T>>> loaders, unsigned int _windowsize, MergeAlignment _alignment = MergeAlignment::asof, size_t chunk = 4096) : 
+			inputs(), 
+			windowsize(_windowsize), 
+			alignment(_alignment), 
+			heap(), 
+			lasttime(loaders.size(), 0.0), 
+			lastvalue(loaders.size()), 
+			started(loaders.size(), false), 
+			present(loaders.size(), false), 
+			row(loaders.size()), 
+			timestamps(), 
+			columns(loaders.size()), 
+			start(0), 
+			finished(false) 
+		{
+			
+			if(loaders.empty() || windowsize == 0) throw MergeSourceInvalidException(); 
+			
+			inputs.reserve(loaders.size()); 
+			for(auto & l : loaders) inputs.push_back(TimedStream<T>(move(l), chunk)); 
+			
+			for(unsigned int c = 0; c < inputs.size(); c++) push(c); 
+			
+		}
+		
+		MergeSource(MergeSource<T> const & cpy) = delete; 
+		MergeSource<T>& operator =(const MergeSource<T>& cpy) = delete; 
+		
+		MergeSource(MergeSource<T> && mv) = default; 
+		MergeSource<T>& operator =(MergeSource<T> && mv) = delete; 
+		~MergeSource() = default; 
+		
+		//the values of input c in the window
+		T * get(unsigned int c) { 
+			if(!fill()) throw MergeSourceInvalidException(); 
+			return columns[c].data() + start; 
+		}
+		
+		//the timestamps of the rows in the window
+		const double * times() { 
+			if(!fill()) throw MergeSourceInvalidException(); 
+			return timestamps.data() + start; 
+		}
+		
+		inline unsigned int channels() const { return inputs.size(); }
+		inline unsigned int getwindowsize() const { return windowsize; }
+		
+		void tick() { start++; }
+		
+		bool eods() { return !fill(); }
+		
+};
+
+}
+
+#endif
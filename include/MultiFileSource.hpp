@@ -0,0 +1,391 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+A FileSource over an ordered list of files (or a glob, which is expanded in 
+sorted order), presented as one continuous stream. This is what you want for 
+data that arrives as rotated files: windows that span the boundary between 
+two files are just windows. 
+
+While one file is being read, the next is opened and the start of it parsed 
+in the background, so crossing into it doesn't stall on the first read. 
+
+*/
+
+#ifndef MultiFileSource_HEADER
+#define MultiFileSource_HEADER
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <exception>
+#include <limits>
+#include <deque>
+#include <mutex>
+#include <functional>
+#include <glob.h>
+
+#include "DataSource.hpp"
+#include "AsyncIOImpl.hpp"
+#include "FileSource.hpp"
+
+using std::string;
+using std::vector;
+using std::unique_ptr; 
+using std::ifstream;
+using std::future;
+using std::exception; 
+using std::move;
+using std::numeric_limits;
+using std::function;
+
+namespace libsim 
+{
+
+class MultiFileSourceInvalidException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "no files to read";
+	}
+	
+};
+
+template <class T, unsigned int N = 0>
+class MultiFileSourceImpl;
+
+template <class T, unsigned int N = 0>
+class MultiFileSource : public DataSource<T, N> {
+	
+	private:
+		unique_ptr<MultiFileSourceImpl<T, N>> impl;
+		
+		static vector<string> expand(string pattern) {
+			
+			vector<string> files; 
+			
+			glob_t matches; 
+			if(glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+				for(size_t i = 0; i < matches.gl_pathc; i++) {
+					files.push_back(matches.gl_pathv[i]); 
+				}
+			}
+			globfree(&matches); 
+			
+			return files; 
+			
+		}
+	
+	public:
+		MultiFileSource(vector<string> _files, unsigned int _wsize, launch _policy) : DataSource<T, N>(_wsize)
+		{
+			impl = unique_ptr<MultiFileSourceImpl<T, N>>(new MultiFileSourceImpl<T, N>(_files, _wsize, _policy, numeric_limits<unsigned int>::max()));
+		}
+		
+		MultiFileSource(vector<string> _files, unsigned int _wsize) : DataSource<T, N>(_wsize)
+		{
+			impl = unique_ptr<MultiFileSourceImpl<T, N>>(new MultiFileSourceImpl<T, N>(_files, _wsize, launch::deferred, numeric_limits<unsigned int>::max()));
+		}
+		
+		MultiFileSource(string _pattern, unsigned int _wsize, launch _policy) : DataSource<T, N>(_wsize)
+		{
+			impl = unique_ptr<MultiFileSourceImpl<T, N>>(new MultiFileSourceImpl<T, N>(expand(_pattern), _wsize, _policy, numeric_limits<unsigned int>::max()));
+		}
+		
+		MultiFileSource(string _pattern, unsigned int _wsize) : DataSource<T, N>(_wsize)
+		{
+			impl = unique_ptr<MultiFileSourceImpl<T, N>>(new MultiFileSourceImpl<T, N>(expand(_pattern), _wsize, launch::deferred, numeric_limits<unsigned int>::max()));
+		}
+		
+		//No copying. That would leave this object in a horrendous state
+		//and I don't want to figure out how to do it. 
+		MultiFileSource(MultiFileSource<T, N> const & cpy) = delete; 
+		MultiFileSource<T, N>& operator =(const MultiFileSource<T, N>& cpy) = delete; 
+	
+		//Moving is fine, so support rvalue move and move assignment operators.
+		MultiFileSource(MultiFileSource<T, N> && mv) : DataSource<T, N>(mv.windowsize), impl(move(mv.impl)) {}
+		MultiFileSource<T, N>& operator =(MultiFileSource<T, N> && mv) { impl = move(mv.impl); return *this; }
+		~MultiFileSource() = default; 
+		
+		inline virtual T * get() override { return impl->get(); };
+		inline virtual void tick() override { impl->tock(); };
+		inline virtual bool eods() override { return impl->eods(); };
+		
+		//Abandon the stream early: outstanding io stops at the next element.
+		inline void cancel() { if(impl) impl->cancel(); };
+		
+		//Bounds, in elements, on the adaptive read size. 
+		inline void setreadbounds(unsigned int _min, unsigned int _max) { impl->setreadbounds(_min, _max); };
+		inline size_t getheld() const { return impl->getheld(); };
+		
+		//Without blocking: is a window (or the end of the data) here yet? If 
+		//not, whenready() calls back from the io thread when it might be. 
+		inline bool poll() { return impl->poll(); };
+		inline bool whenready(function<void()> callback) { return impl->whenready(move(callback)); };
+		
+		inline virtual WindowBatch<T> batch(unsigned int k) override { return impl->batch(k); };
+		inline virtual SourceCheckpoint checkpoint() override { return impl->checkpoint(); };
+		inline virtual void restore(const SourceCheckpoint & cp) override { impl->restore(cp); };
+		
+};
+
+template <class T, unsigned int N>
+class MultiFileSourceImpl : public AsyncIOImpl<T, N> {
+	
+	private:
+		//A file that has been opened ahead of time, along with the values
+		//parsed from the start of it. 
+		struct Prefetched {
+			ifstream file; 
+			vector<T> head; 
+		};
+		
+		const vector<string> files; 
+		unsigned int current; 
+		
+		ifstream file;
+		vector<T> head; 
+		unsigned int headpos; 
+		
+		future<unique_ptr<Prefetched>> nextfile; 
+		
+		//As in FileSourceImpl, where loads started, so that a checkpoint can 
+		//point at a line near the window; here the file is recorded too. 
+		struct Mark {
+			unsigned long index; 
+			unsigned int segment; 
+			std::streamoff offset; 
+		};
+		std::deque<Mark> marks; 
+		std::mutex marklock; 
+		
+		//Called with marklock held. 
+		inline void prune() {
+			while(marks.size() > 1 && marks[1].index <= this->position) marks.pop_front(); 
+		}
+		
+		virtual void loaded() override {
+			std::lock_guard<std::mutex> guard(marklock); 
+			prune(); 
+		}
+		
+		inline void mark(std::streamoff offset) {
+			
+			if(offset < 0) return; 
+			
+			Mark m; 
+			m.index = this->datapoints_read; 
+			m.segment = current; 
+			m.offset = offset; 
+			
+			std::lock_guard<std::mutex> guard(marklock); 
+			marks.push_back(m); 
+			
+		}
+		
+		//Open the file after the current one and parse its first extent lines.
+		inline void prefetch(unsigned int extent) {
+			
+			if(current + 1 >= files.size()) return; 
+			
+			string fn = files[current + 1]; 
+			
+			nextfile = async(launch::async, [this, fn, extent]() {
+				
+				unique_ptr<Prefetched> pre(new Prefetched()); 
+				pre->file.open(fn); 
+				pre->head.reserve(extent); 
+				
+				string stemp; 
+				while(pre->head.size() < extent && !this->cancelled && getline(pre->file, stemp)) {
+					pre->head.push_back(parsevalue<T>(stemp)); 
+				}
+				
+				return pre; 
+				
+			});
+			
+		}
+		
+		//Move on to the next file, which should already be open. 
+		inline bool advance() {
+			
+			if(current + 1 >= files.size()) return false; 
+			
+			auto pre = nextfile.get(); 
+			
+			file = move(pre->file); 
+			head = move(pre->head); 
+			headpos = 0; 
+			current++; 
+			
+			//The head was parsed from the start of the file. 
+			mark(0); 
+			
+			prefetch(this->read_extent); 
+			
+			return true; 
+			
+		}
+	
+		inline vector<T> load() {
+			
+			auto tmpdata = vector<T>();
+			tmpdata.reserve(this->read_extent);
+			
+			string stemp; 
+			
+			//Unless we're still in the prefetched head, whose mark is the 
+			//start of the file. 
+			if(headpos == head.size()) mark(file.tellg()); 
+			
+			while(tmpdata.size() < this->read_extent)  {
+				if(this->datapoints_read == this->datapoints_limit) break; 
+				if(this->cancelled) break;
+				
+				if(headpos < head.size()) {
+					tmpdata.push_back(head[headpos++]); 
+				}
+				else if(getline(file, stemp)) {
+					tmpdata.push_back(parsevalue<T>(stemp)); 
+				}
+				else {
+					if(!advance()) break; 
+					continue; 
+				}
+				
+				this->datapoints_read++;
+			}
+			
+			if(headpos == head.size()) vector<T>().swap(head); 
+			
+			this->readyio = true; 
+			
+			return tmpdata;
+			
+		}
+	
+		virtual vector<T> ioinit() override { return load(); }
+		virtual vector<T> ionext() override { return load(); }
+		
+	public:
+		MultiFileSourceImpl(vector<string> _files, unsigned int _wsize, launch _policy, unsigned int datapoints) :
+			AsyncIOImpl<T, N>(_wsize, _policy, datapoints),
+			files(_files),
+			current(0),
+			file(),
+			head(),
+			headpos(0),
+			nextfile(),
+			marks(1, Mark{0, 0, 0}),
+			marklock()
+		{
+			
+			if(files.empty()) throw MultiFileSourceInvalidException(); 
+			
+			file.open(files[0]); 
+			
+			prefetch(this->read_extent); 
+			
+			this->prime();
+			
+		}
+		
+		//Absolutely no copying. 
+		MultiFileSourceImpl(MultiFileSourceImpl<T, N> const & cpy) = delete; 
+		MultiFileSourceImpl<T, N>& operator =(const MultiFileSourceImpl<T, N>& cpy) = delete; 
+		
+		MultiFileSourceImpl(MultiFileSourceImpl<T, N> && mv) = delete; 
+		MultiFileSourceImpl<T, N>& operator =(MultiFileSourceImpl<T, N> && mv) = delete; 
+		~MultiFileSourceImpl() {
+			
+			//Stop the io, and the prefetch, before the files go away. 
+			this->cancel();
+			if(nextfile.valid()) nextfile.wait(); 
+			
+		}
+		
+		SourceCheckpoint checkpoint() {
+			
+			std::lock_guard<std::mutex> guard(marklock); 
+			
+			prune(); 
+			
+			if(marks.empty() || marks[0].index > this->position) throw CheckpointUnsupportedException(); 
+			
+			SourceCheckpoint cp(CheckpointKind::multifile, this->getwindowsize(), this->position); 
+			cp.segment = marks[0].segment; 
+			cp.base = marks[0].index; 
+			cp.offset = marks[0].offset; 
+			
+			return cp; 
+			
+		}
+		
+		void restore(const SourceCheckpoint & cp) {
+			
+			cp.expect(CheckpointKind::multifile, this->getwindowsize()); 
+			if(cp.base > cp.index || cp.segment >= files.size()) throw CheckpointInvalidException(); 
+			
+			//As in FileSourceImpl, find the place before giving up the current one.
+			ifstream scratch(files[cp.segment]); 
+			scratch.seekg(cp.offset); 
+			
+			string stemp; 
+			for(unsigned long skip = cp.index - cp.base; skip > 0; skip--) {
+				if(!getline(scratch, stemp)) throw CheckpointInvalidException(); 
+			}
+			if(!scratch) throw CheckpointInvalidException(); 
+			
+			this->settle(); 
+			if(nextfile.valid()) nextfile.wait(); 
+			
+			{
+				std::lock_guard<std::mutex> guard(marklock); 
+				marks.clear(); 
+				marks.push_back(Mark{cp.index, cp.segment, scratch.tellg()}); 
+			}
+			
+			current = cp.segment; 
+			vector<T>().swap(head); 
+			headpos = 0; 
+			
+			file = move(scratch); 
+			
+			prefetch(this->read_extent); 
+			
+			this->restart(cp.index); 
+			
+		}
+		
+};
+
+}
+
+#endif
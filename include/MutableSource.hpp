@@ -26,47 +26,24 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 /* 
-The vector data source is simple; it takes in a vector of data (compiled by another class etc) and 
-utilises it as the data passed out through the window. 
+A VectorSource with a push_back() mechanism, so the data can be added to as the window moves along it. 
 */
 
 #ifndef MutableSource_HEADER
 #define MutableSource_HEADER
 
-#include <vector>
-#include <utility>
+#include <memory>
 
-#include "VectorSource.hpp"
+#include "WindowedSource.hpp"
 
-using std::vector;
-using std::move; 
+using std::allocator;
 
 namespace libsim 
 {
 
-template<class T>
-class MutableSource : public VectorSource<T> {
-
-	public:
-		MutableSource(vector<T> _data, unsigned int _windowsize) : VectorSource<T>(_data, _windowsize) {}
-		
-		//Again, no copying
-		MutableSource(MutableSource<T> const & cpy) = delete; 
-		MutableSource<T>& operator =(const MutableSource<T>& cpy) = delete; 
-	
-		//Moving is fine, so support rvalue move and move assignment operators.
-		MutableSource(MutableSource<T> && mv) : VectorSource<T>(mv.data, mv.windowsize) {}
-		MutableSource<T>& operator = (MutableSource<T> && mv) { this->data = move(mv.data); this->start = mv.start; return *this; }
-		~MutableSource() = default; 
-    
-		void push_back(T temp) {
-		
-			this->data.push_back(temp);
-		  
-		}
-		
-};
+template<class T, unsigned int N = 0, class Alloc = allocator<T>>
+using MutableSource = WindowedSource<T, AppendableStorage<T, Alloc>, N>; 
 
 }
 
-#endif
\ No newline at end of file
+#endif
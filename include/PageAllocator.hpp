@@ -0,0 +1,313 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+An allocator for the library's large buffers: the in-memory sources, the 
+AsyncIOImpl buffer and RingSource's ring. Scanning tens of GB with ordinary 
+4KB pages spends much of its time in TLB misses, and on a multi-socket machine 
+memory that landed on the wrong node is read over the interconnect. 
+
+A MemoryPolicy says what to do about each: 
+
+	pages: normal leaves it to the OS; transparent maps 2MB-aligned memory and 
+	asks for transparent huge pages (madvise); hugetlb takes explicit huge pages
+	from the reserved pool (vm.nr_hugepages), falling back to transparent if 
+	there aren't any. 
+	
+	numa: firsttouch leaves pages on the node of the thread that first writes 
+	them, which is the consumer for the async buffers; local prefers the node 
+	of the allocating thread; node binds them to a given node; interleave 
+	spreads them over every node, for data scanned by threads on all of them. 
+	
+Only allocations of at least threshold bytes are affected; anything smaller 
+goes to operator new as usual. The default policy does nothing at all, so an 
+unconfigured PageAllocator behaves like std::allocator. Each allocator takes a 
+copy of MemoryPolicy::getdefault() when it is constructed, unless it is given 
+one, and keeps it for the life of the container. 
+
+NUMA binding uses the mbind system call directly, so there is nothing extra 
+to link; on other platforms, and on kernels without NUMA, it is ignored. 
+
+*/
+
+#ifndef PageAllocator_HEADER
+#define PageAllocator_HEADER
+
+#include <new>
+#include <mutex>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using std::mutex;
+using std::lock_guard;
+using std::size_t; 
+
+namespace libsim 
+{
+
+enum class PageMode { normal, transparent, hugetlb };
+enum class NumaMode { firsttouch, local, node, interleave };
+
+struct MemoryPolicy {
+	
+	PageMode pages; 
+	NumaMode numa; 
+	int node; 
+	size_t threshold; 
+	
+	MemoryPolicy(PageMode _pages = PageMode::normal, NumaMode _numa = NumaMode::firsttouch, int _node = 0, size_t _threshold = 1 << 20) : 
+		pages(_pages), numa(_numa), node(_node), threshold(_threshold) {}
+	
+	inline bool operator ==(const MemoryPolicy & rhs) const {
+		return pages == rhs.pages && numa == rhs.numa && node == rhs.node && threshold == rhs.threshold; 
+	}
+	
+	inline bool operator !=(const MemoryPolicy & rhs) const { return !(*this == rhs); }
+	
+	//The policy new allocators start with. Changing it doesn't affect 
+	//containers that already exist. 
+	static MemoryPolicy getdefault() {
+		lock_guard<mutex> guard(lock()); 
+		return current(); 
+	}
+	
+	static void setdefault(const MemoryPolicy & policy) {
+		lock_guard<mutex> guard(lock()); 
+		current() = policy; 
+	}
+	
+	private:
+		static mutex & lock() { static mutex m; return m; }
+		static MemoryPolicy & current() { static MemoryPolicy p; return p; }
+	
+};
+
+//The mapping and binding, independent of T. 
+class PageMapper {
+	
+	public:
+		static inline size_t hugepage() { return 2 << 20; }
+		
+		//True if allocations of this size are mapped rather than new'd. 
+		static inline bool mapped(const MemoryPolicy & policy, size_t bytes) {
+#ifdef __linux__
+			if(bytes < policy.threshold) return false; 
+			return policy.pages != PageMode::normal || policy.numa != NumaMode::firsttouch; 
+#else
+			return false; 
+#endif
+		}
+		
+		//The length actually mapped, which deallocation has to match. 
+		static inline size_t length(const MemoryPolicy & policy, size_t bytes) {
+			size_t unit = (policy.pages == PageMode::normal) ? pagesize() : hugepage(); 
+			return ((bytes + unit - 1) / unit) * unit; 
+		}
+		
+		static void * map(const MemoryPolicy & policy, size_t bytes) {
+			
+#ifdef __linux__
+			size_t len = length(policy, bytes); 
+			void * addr = MAP_FAILED; 
+			
+			if(policy.pages == PageMode::hugetlb) {
+				addr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0); 
+			}
+			
+			if(addr == MAP_FAILED && policy.pages != PageMode::normal) {
+				addr = aligned(len); 
+#ifdef MADV_HUGEPAGE
+				if(addr != MAP_FAILED) madvise(addr, len, MADV_HUGEPAGE); 
+#endif
+			}
+			
+			if(addr == MAP_FAILED && policy.pages == PageMode::normal) {
+				addr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0); 
+			}
+			
+			if(addr == MAP_FAILED) throw std::bad_alloc(); 
+			
+			bind(policy, addr, len); 
+			
+			return addr; 
+#else
+			throw std::bad_alloc(); 
+#endif
+			
+		}
+		
+		static void unmap(const MemoryPolicy & policy, void * addr, size_t bytes) {
+#ifdef __linux__
+			munmap(addr, length(policy, bytes)); 
+#endif
+		}
+		
+		//The NUMA node the calling thread is running on, or -1. 
+		static int currentnode() {
+#if defined(__linux__) && defined(SYS_getcpu)
+			unsigned int cpu = 0, node = 0; 
+			if(syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) return node; 
+#endif
+			return -1; 
+		}
+	
+	private:
+		static size_t pagesize() {
+#ifdef __linux__
+			static const size_t size = sysconf(_SC_PAGESIZE); 
+			return size; 
+#else
+			return 4096; 
+#endif
+		}
+		
+#ifdef __linux__
+		//Maps len bytes at a huge page boundary, by mapping more than that and
+		//trimming either end. 
+		static void * aligned(size_t len) {
+			
+			void * raw = mmap(nullptr, len + hugepage(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0); 
+			if(raw == MAP_FAILED) return MAP_FAILED; 
+			
+			uintptr_t base = reinterpret_cast<uintptr_t>(raw); 
+			uintptr_t start = (base + hugepage() - 1) & ~(uintptr_t) (hugepage() - 1); 
+			
+			if(start > base) munmap(raw, start - base); 
+			if(base + hugepage() > start) munmap(reinterpret_cast<void *>(start + len), base + hugepage() - start); 
+			
+			return reinterpret_cast<void *>(start); 
+			
+		}
+		
+		static void bind(const MemoryPolicy & policy, void * addr, size_t len) {
+			
+#ifdef SYS_mbind
+			//From linux/mempolicy.h
+			const int MPOL_PREFERRED_ = 1, MPOL_BIND_ = 2, MPOL_INTERLEAVE_ = 3; 
+			
+			int mode; 
+			unsigned long mask[16] = { 0 }; 
+			const unsigned long maxnode = sizeof(mask) * 8; 
+			
+			switch(policy.numa) {
+				case NumaMode::firsttouch: 
+					return; 
+				case NumaMode::local: {
+					int node = currentnode(); 
+					if(node < 0) return; 
+					mode = MPOL_PREFERRED_; 
+					mask[node / 64] |= 1ul << (node % 64); 
+					break; 
+				}
+				case NumaMode::node: 
+					if(policy.node < 0 || (unsigned long) policy.node >= maxnode) return; 
+					mode = MPOL_BIND_; 
+					mask[policy.node / 64] |= 1ul << (policy.node % 64); 
+					break; 
+				case NumaMode::interleave: 
+					mode = MPOL_INTERLEAVE_; 
+					for(auto & m : mask) m = ~0ul; 
+					break; 
+				default: 
+					return; 
+			}
+			
+			//Failure (no NUMA, or no such node) leaves the default policy, 
+			//which is still correct, just not placed. 
+			syscall(SYS_mbind, addr, len, mode, mask, maxnode, 0); 
+#endif
+			
+		}
+#endif
+	
+};
+
+template<class T>
+class PageAllocator {
+	
+	private:
+		template<class U> friend class PageAllocator; 
+		MemoryPolicy policy; 
+	
+	public:
+		typedef T value_type; 
+		typedef std::true_type propagate_on_container_move_assignment; 
+		typedef std::true_type propagate_on_container_copy_assignment; 
+		typedef std::true_type propagate_on_container_swap; 
+		
+		template<class U>
+		struct rebind { typedef PageAllocator<U> other; };
+		
+		PageAllocator() : policy(MemoryPolicy::getdefault()) {}
+		explicit PageAllocator(const MemoryPolicy & _policy) : policy(_policy) {}
+		
+		template<class U>
+		PageAllocator(const PageAllocator<U> & other) : policy(other.policy) {}
+		
+		T * allocate(size_t n) {
+			
+			if(n > std::numeric_limits<size_t>::max() / sizeof(T)) throw std::bad_alloc(); 
+			
+			size_t bytes = n * sizeof(T); 
+			
+			if(PageMapper::mapped(policy, bytes)) return static_cast<T *>(PageMapper::map(policy, bytes)); 
+			
+			return static_cast<T *>(::operator new(bytes)); 
+			
+		}
+		
+		void deallocate(T * p, size_t n) {
+			
+			size_t bytes = n * sizeof(T); 
+			
+			if(PageMapper::mapped(policy, bytes)) PageMapper::unmap(policy, p, bytes); 
+			else ::operator delete(p); 
+			
+		}
+		
+		inline const MemoryPolicy & getpolicy() const { return policy; }
+		
+		template<class U>
+		inline bool operator ==(const PageAllocator<U> & rhs) const { return policy == rhs.policy; }
+		
+		template<class U>
+		inline bool operator !=(const PageAllocator<U> & rhs) const { return policy != rhs.policy; }
+		
+};
+
+}
+
+#endif
@@ -0,0 +1,443 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+Applies a function to every window of a source on a pool of threads, and 
+gives back the results in the order of the windows, as a stream with the 
+same get()/tick()/eods() shape as a source. 
+
+	auto pm = parallel_map(source, [](const double * w, unsigned int n) { return model(w, n); }, 8);
+	while(!pm.eods()) { use(pm.get()); pm.tick(); }
+
+One thread reads the source: it takes up to grain windows at a time with 
+batch(), copies the elements they cover (grain + W - 1 of them, since the 
+windows overlap) into a task, and ticks past them, so a FileSource or 
+SQLiteSource keeps prefetching as usual. Tasks are dealt round-robin onto a 
+deque per worker; a worker takes the oldest task from its own deque and, when
+that is empty, steals the newest from another's, so expensive windows don't 
+leave the other threads idle. 
+
+Finished tasks wait in a reorder buffer of a fixed number of tasks (4 per 
+thread by default) until every earlier one has been handed out. The reader 
+stops when the buffer is full, so memory stays bounded however far the 
+workers could get ahead of whatever consumes the results. 
+
+The source is borrowed, must outlive the ParallelMap, and must not be 
+touched while the ParallelMap exists. An exception from the function is 
+rethrown by get() for the window that threw it; one from the source by 
+eods() once the windows before it have been handed out. 
+
+*/
+
+#ifndef ParallelMap_HEADER
+#define ParallelMap_HEADER
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <utility>
+
+#include "DataSource.hpp"
+
+using std::vector;
+using std::deque;
+using std::unique_ptr;
+using std::thread;
+using std::mutex;
+using std::condition_variable;
+using std::function;
+using std::exception; 
+using std::exception_ptr;
+using std::move;
+
+namespace libsim 
+{
+
+class ParallelMapInvalidException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "no result: the source has ended";
+	}
+	
+};
+
+template<class T, class R>
+class ParallelMapImpl;
+
+template<class T, class R>
+class ParallelMap {
+	
+	private:
+		unique_ptr<ParallelMapImpl<T, R>> impl;
+	
+	public:
+		ParallelMap(DataSource<T> & source, function<R(const T *, unsigned int)> fn, unsigned int threads = 0, unsigned int grain = 64, unsigned int capacity = 0) :
+			impl(new ParallelMapImpl<T, R>(source, fn, threads, grain, capacity)) {}
+		
+		//No copying; there is only one set of threads. 
+		ParallelMap(ParallelMap<T, R> const & cpy) = delete; 
+		ParallelMap<T, R>& operator =(const ParallelMap<T, R>& cpy) = delete; 
+		
+		ParallelMap(ParallelMap<T, R> && mv) : impl(move(mv.impl)) {}
+		ParallelMap<T, R>& operator =(ParallelMap<T, R> && mv) { impl = move(mv.impl); return *this; }
+		~ParallelMap() = default; 
+		
+		//the result for the current window
+		inline R & get() { return impl->get(); }
+		inline void tick() { impl->tick(); }
+		inline bool eods() { return impl->eods(); }
+		
+		inline unsigned int getthreads() const { return impl->getthreads(); }
+		
+};
+
+template<class T, class F>
+ParallelMap<T, decltype(std::declval<F>()(std::declval<const T *>(), 0u))> parallel_map(DataSource<T> & source, F fn, unsigned int threads = 0, unsigned int grain = 64) {
+	return ParallelMap<T, decltype(std::declval<F>()(std::declval<const T *>(), 0u))>(source, fn, threads, grain); 
+}
+
+template<class T, class R>
+class ParallelMapImpl {
+	
+	private:
+		//Consecutive windows: row r is data.data() + r. 
+		struct Task {
+			unsigned long id; 
+			unsigned int rows; 
+			vector<T> data; 
+		};
+		
+		struct Worker {
+			deque<Task> tasks; 
+			mutex lock; 
+		};
+		
+		//Where task id % capacity puts its results; a deque rather than a 
+		//vector so that get() can return a reference even when R is bool. 
+		//Rows whose function threw have no result, but the row and what it 
+		//threw, in row order. 
+		struct Slot {
+			deque<R> results; 
+			vector<unsigned int> failed; 
+			vector<exception_ptr> errors; 
+			unsigned int rows; 
+			bool ready; 
+		};
+		
+		DataSource<T> * source; 
+		function<R(const T *, unsigned int)> fn; 
+		const unsigned int windowsize; 
+		const unsigned int grain; 
+		
+		vector<unique_ptr<Worker>> workers; 
+		vector<Slot> slots; 
+		
+		//Guards the slots and the counters below. 
+		mutex lock; 
+		condition_variable work; 
+		condition_variable space; 
+		condition_variable done; 
+		
+		unsigned long produced; 
+		unsigned long consumed; 
+		unsigned long queued; 
+		bool ended; 
+		bool stopping; 
+		exception_ptr sourceerror; 
+		
+		//Only touched by the consumer. 
+		unsigned int row; 
+		
+		vector<thread> threads; 
+		thread reader; 
+		
+		inline void read() {
+			
+			try {
+				
+				while(true) {
+					
+					{
+						std::unique_lock<mutex> guard(lock); 
+						space.wait(guard, [this]() { return stopping || produced - consumed < slots.size(); }); 
+						if(stopping) break; 
+					}
+					
+					if(source->eods()) break; 
+					
+					WindowBatch<T> b = source->batch(grain); 
+					
+					Task task; 
+					task.rows = b.rows(); 
+					task.data.assign(b.data(), b.data() + task.rows + windowsize - 1); 
+					
+					for(unsigned int r = 0; r < task.rows; r++) source->tick(); 
+					
+					unsigned long id; 
+					{
+						std::lock_guard<mutex> guard(lock); 
+						id = produced; 
+						Slot & slot = slots[id % slots.size()]; 
+						slot.results.clear(); 
+						slot.failed.clear(); 
+						slot.errors.clear(); 
+						slot.rows = task.rows; 
+						slot.ready = false; 
+					}
+					
+					task.id = id; 
+					
+					{
+						Worker & w = *workers[id % workers.size()]; 
+						std::lock_guard<mutex> guard(w.lock); 
+						w.tasks.push_back(move(task)); 
+					}
+					
+					{
+						std::lock_guard<mutex> guard(lock); 
+						produced++; 
+						queued++; 
+					}
+					work.notify_one(); 
+					
+				}
+				
+			}
+			catch(...) {
+				std::lock_guard<mutex> guard(lock); 
+				sourceerror = std::current_exception(); 
+			}
+			
+			{
+				std::lock_guard<mutex> guard(lock); 
+				ended = true; 
+			}
+			done.notify_all(); 
+			
+		}
+		
+		//The oldest task on our own deque, or else the newest on someone else's.
+		inline bool take(unsigned int me, Task & task) {
+			
+			for(unsigned int i = 0; i < workers.size(); i++) {
+				
+				Worker & w = *workers[(me + i) % workers.size()]; 
+				std::lock_guard<mutex> guard(w.lock); 
+				
+				if(w.tasks.empty()) continue; 
+				
+				if(i == 0) {
+					task = move(w.tasks.front()); 
+					w.tasks.pop_front(); 
+				}
+				else {
+					task = move(w.tasks.back()); 
+					w.tasks.pop_back(); 
+				}
+				
+				return true; 
+				
+			}
+			
+			return false; 
+			
+		}
+		
+		inline void run(unsigned int me) {
+			
+			Task task; 
+			deque<R> results; 
+			vector<unsigned int> failed; 
+			vector<exception_ptr> errors; 
+			
+			while(true) {
+				
+				{
+					std::unique_lock<mutex> guard(lock); 
+					work.wait(guard, [this]() { return stopping || queued > 0; }); 
+					if(stopping) return; 
+					//Claim one; it is on some deque, if not necessarily ours. 
+					queued--; 
+				}
+				
+				while(!take(me, task)) std::this_thread::yield(); 
+				
+				results.clear(); 
+				failed.clear(); 
+				errors.clear(); 
+				
+				//A window that throws doesn't stop the rest of the task. 
+				for(unsigned int r = 0; r < task.rows; r++) {
+					try {
+						results.push_back(fn(task.data.data() + r, windowsize)); 
+					}
+					catch(...) {
+						failed.push_back(r); 
+						errors.push_back(std::current_exception()); 
+					}
+				}
+				
+				{
+					std::lock_guard<mutex> guard(lock); 
+					Slot & slot = slots[task.id % slots.size()]; 
+					slot.results.swap(results); 
+					slot.failed.swap(failed); 
+					slot.errors.swap(errors); 
+					slot.ready = true; 
+				}
+				done.notify_all(); 
+				
+			}
+			
+		}
+		
+		//Wait until the current task is finished, or there are no more. 
+		inline Slot * current() {
+			
+			std::unique_lock<mutex> guard(lock); 
+			
+			done.wait(guard, [this]() { 
+				return (consumed < produced && slots[consumed % slots.size()].ready) || (ended && consumed == produced); 
+			}); 
+			
+			if(consumed == produced) {
+				if(sourceerror) std::rethrow_exception(sourceerror); 
+				return nullptr; 
+			}
+			
+			return &slots[consumed % slots.size()]; 
+			
+		}
+		
+	public:
+		ParallelMapImpl(DataSource<T> & _source, function<R(const T *, unsigned int)> _fn, unsigned int nthreads, unsigned int _grain, unsigned int capacity) : 
+			source(&_source), 
+			fn(_fn), 
+			windowsize(_source.getwindowsize()), 
+			grain(_grain == 0 ? 1 : _grain), 
+			workers(), 
+			slots(), 
+			lock(), 
+			work(), 
+			space(), 
+			done(), 
+			produced(0), 
+			consumed(0), 
+			queued(0), 
+			ended(false), 
+			stopping(false), 
+			sourceerror(), 
+			row(0), 
+			threads(), 
+			reader() 
+		{
+			
+			if(nthreads == 0) nthreads = std::max(thread::hardware_concurrency(), 1u); 
+			if(capacity == 0) capacity = 4 * nthreads; 
+			
+			slots.resize(capacity); 
+			for(Slot & slot : slots) slot.ready = false; 
+			
+			for(unsigned int i = 0; i < nthreads; i++) {
+				workers.push_back(unique_ptr<Worker>(new Worker())); 
+			}
+			
+			for(unsigned int i = 0; i < nthreads; i++) {
+				threads.push_back(thread(&ParallelMapImpl<T, R>::run, this, i)); 
+			}
+			
+			reader = thread(&ParallelMapImpl<T, R>::read, this); 
+			
+		}
+		
+		//Absolutely no copying. 
+		ParallelMapImpl(ParallelMapImpl<T, R> const & cpy) = delete; 
+		ParallelMapImpl<T, R>& operator =(const ParallelMapImpl<T, R>& cpy) = delete; 
+		
+		ParallelMapImpl(ParallelMapImpl<T, R> && mv) = delete; 
+		ParallelMapImpl<T, R>& operator =(ParallelMapImpl<T, R> && mv) = delete; 
+		~ParallelMapImpl() {
+			
+			{
+				std::lock_guard<mutex> guard(lock); 
+				stopping = true; 
+			}
+			work.notify_all(); 
+			space.notify_all(); 
+			
+			reader.join(); 
+			for(thread & t : threads) t.join(); 
+			
+		}
+		
+		R & get() {
+			
+			Slot * slot = current(); 
+			if(slot == nullptr) throw ParallelMapInvalidException(); 
+			
+			//Results skip the rows that threw. 
+			unsigned int skipped = 0; 
+			for(unsigned int i = 0; i < slot->failed.size() && slot->failed[i] <= row; i++) {
+				if(slot->failed[i] == row) std::rethrow_exception(slot->errors[i]); 
+				skipped++; 
+			}
+			
+			return slot->results[row - skipped]; 
+			
+		}
+		
+		void tick() {
+			
+			Slot * slot = current(); 
+			if(slot == nullptr) return; 
+			
+			if(++row < slot->rows) return; 
+			
+			row = 0; 
+			{
+				std::lock_guard<mutex> guard(lock); 
+				consumed++; 
+			}
+			space.notify_one(); 
+			
+		}
+		
+		bool eods() { return current() == nullptr; }
+		
+		inline unsigned int getthreads() const { return threads.size(); }
+		
+};
+
+}
+
+#endif
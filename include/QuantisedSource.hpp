@@ -0,0 +1,157 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* 
+A source that holds its data as small unsigned integers, with a scale and an 
+offset for each block, and decodes the windows back to T as they are used 
+(see DecodedSource.hpp). For data that only has 12 to 16 bits of real 
+precision, such as samples from an ADC, QuantisedSource<double> holds a 
+quarter of what a VectorSource<double> does, and QuantisedSource<double, 
+uint8_t> an eighth, so far more of the history fits in cache. 
+
+Each block is mapped linearly from its own minimum to its own maximum onto 
+the whole range of Q, so the error in any element is at most half a step of 
+its block, which geterror() reports. Integer data whose blocks each span no 
+more than the range of Q comes back exactly. 
+
+	auto qs = QuantisedSource<double>(samples, 128); 
+
+Decoding is one multiply and add per element over a run of Q, which the 
+compiler vectorises when optimising. 
+*/
+
+#ifndef QuantisedSource_HEADER
+#define QuantisedSource_HEADER
+
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+#include "DecodedSource.hpp"
+
+using std::vector;
+using std::numeric_limits;
+using std::size_t; 
+
+namespace libsim 
+{
+
+template<class T, class Q = uint16_t>
+class QuantisedCodec {
+	
+	static_assert(std::is_integral<Q>::value && std::is_unsigned<Q>::value, "Q must be an unsigned integer type");
+	
+	private:
+		vector<Q> codes; 
+		vector<double> offsets; 
+		vector<double> scales; 
+		size_t blockelements; 
+		
+		static inline T convert(double v, std::true_type) { return (T) std::floor(v + 0.5); }
+		static inline T convert(double v, std::false_type) { return (T) v; }
+		
+		void encode(const T * values, size_t count) {
+			
+			codes.resize(count); 
+			
+			for(size_t from = 0; from < count; from += blockelements) {
+				
+				size_t to = std::min(from + blockelements, count); 
+				
+				auto range = std::minmax_element(values + from, values + to); 
+				double lo = (double) *range.first; 
+				double scale = ((double) *range.second - lo) / numeric_limits<Q>::max(); 
+				
+				for(size_t i = from; i < to; i++) {
+					double q = (scale > 0.0) ? std::floor(((double) values[i] - lo) / scale + 0.5) : 0.0; 
+					codes[i] = (Q) std::max(0.0, std::min(q, (double) numeric_limits<Q>::max())); 
+				}
+				
+				offsets.push_back(lo); 
+				scales.push_back(scale); 
+				
+			}
+			
+		}
+		
+	public:
+		QuantisedCodec(const vector<T> & values, unsigned int _blocksize = 256) : codes(), offsets(), scales(), blockelements(std::max(_blocksize, 1u)) {
+			encode(values.data(), values.size()); 
+		}
+		
+		QuantisedCodec(const T * values, size_t count, unsigned int _blocksize = 256) : codes(), offsets(), scales(), blockelements(std::max(_blocksize, 1u)) {
+			encode(values, count); 
+		}
+		
+		QuantisedCodec(QuantisedCodec<T, Q> const & cpy) = delete; 
+		QuantisedCodec<T, Q>& operator =(const QuantisedCodec<T, Q>& cpy) = delete; 
+		
+		QuantisedCodec(QuantisedCodec<T, Q> && mv) = default; 
+		QuantisedCodec<T, Q>& operator =(QuantisedCodec<T, Q> && mv) = default; 
+		~QuantisedCodec() = default; 
+		
+		inline size_t size() const { return codes.size(); }
+		inline size_t blocksize() const { return blockelements; }
+		inline size_t blocks() const { return offsets.size(); }
+		inline size_t bytes() const { return codes.size() * sizeof(Q) + offsets.size() * 2 * sizeof(double); }
+		
+		size_t decode(size_t block, T * out) const {
+			
+			size_t from = block * blockelements; 
+			size_t n = std::min(blockelements, codes.size() - from); 
+			
+			const Q * q = codes.data() + from; 
+			const double offset = offsets[block]; 
+			const double scale = scales[block]; 
+			
+			for(size_t i = 0; i < n; i++) {
+				out[i] = convert(offset + scale * q[i], std::is_integral<T>()); 
+			}
+			
+			return n; 
+			
+		}
+		
+		//the largest difference between an element and what it decodes to
+		double geterror() const {
+			double step = 0.0; 
+			for(double scale : scales) step = std::max(step, scale); 
+			return step / 2; 
+		}
+		
+};
+
+template<class T, class Q = uint16_t, unsigned int N = 0>
+using QuantisedSource = DecodedSource<T, QuantisedCodec<T, Q>, N>; 
+
+}
+
+#endif
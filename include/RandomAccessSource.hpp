@@ -0,0 +1,370 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+The other sources only move forward. This one can return the window at any 
+index, which is what review tools want when they jump around a large file or 
+table. 
+
+The data is cut into blocks of blocksize windows. Each block also carries the 
+windowsize - 1 elements after it, so every window lies entirely inside one 
+block and windowat() can always return a pointer straight into it. Blocks 
+are read by a BlockLoader and kept in the shared BlockCache; the block in use 
+is held by the source, so repeated lookups in the same block don't touch the 
+cache at all. Whenever the source moves to a new block, the blocks either 
+side of it are loaded in the background. 
+
+It is also an ordinary DataSource: get() and tick() walk forward from 0. 
+
+The pointers returned point into cached blocks that are shared with other 
+sources: don't write through them. 
+
+*/
+
+#ifndef RandomAccessSource_HEADER
+#define RandomAccessSource_HEADER
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <chrono>
+#include <utility>
+#include <exception>
+#include <typeinfo>
+#include <sys/stat.h>
+
+#include "DataSource.hpp"
+#include "FileSource.hpp"
+#include "BlockCache.hpp"
+
+using std::string;
+using std::vector;
+using std::ifstream;
+using std::unique_ptr;
+using std::shared_ptr;
+using std::make_shared;
+using std::mutex;
+using std::lock_guard;
+using std::future;
+using std::async;
+using std::launch;
+using std::move;
+using std::exception; 
+
+namespace libsim 
+{
+
+class RandomAccessOutOfRangeException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "no window at that index";
+	}
+	
+};
+
+template<class T>
+class BlockLoader {
+	
+	public:
+		virtual ~BlockLoader() {}
+		
+		//Load count elements starting at element first, or fewer at the end of
+		//the data. This may be called from several threads at once. 
+		virtual vector<T> load(unsigned long first, unsigned int count) = 0; 
+		
+		//Identifies the data, so that sources over the same data can share 
+		//blocks in the cache. It must change when the data does. 
+		virtual string identity() const = 0; 
+		
+	protected:
+		//The size and modification time of a file, or empty if there isn't 
+		//one, so that a file that is rewritten doesn't match its old blocks. 
+		static string version(const string & filename) {
+			
+			struct stat info; 
+			if(filename.empty() || stat(filename.c_str(), &info) != 0) return string(); 
+			
+			return std::to_string(info.st_size) + "@" + std::to_string(info.st_mtim.tv_sec) + "." + std::to_string(info.st_mtim.tv_nsec); 
+			
+		}
+		
+};
+
+//Text files can't be seeked by line, so this keeps a sparse index of the byte
+//offset of every stride-th line, extended as far as it is needed. A load 
+//seeks to the nearest indexed line and skips fewer than stride lines. 
+template<class T>
+class FileBlockLoader : public BlockLoader<T> {
+	
+	private:
+		const string filename; 
+		const string modified; 
+		ifstream file; 
+		mutex lock; 
+		
+		const unsigned int stride; 
+		vector<std::streamoff> offsets; 
+		bool indexed; 
+		
+		inline void extend() {
+			
+			file.clear(); 
+			file.seekg(offsets.back()); 
+			
+			string stemp; 
+			unsigned int n = 0; 
+			while(n < stride && getline(file, stemp)) n++; 
+			
+			if(n < stride || file.peek() == std::char_traits<char>::eof()) {
+				indexed = true; 
+				return; 
+			}
+			
+			offsets.push_back(file.tellg()); 
+			
+		}
+	
+	public:
+		FileBlockLoader(string _filename, unsigned int _stride = 1024) : 
+			filename(_filename), 
+			modified(BlockLoader<T>::version(_filename)), 
+			file(_filename), 
+			lock(), 
+			stride(_stride), 
+			offsets(1, 0), 
+			indexed(false) 
+		{}
+		
+		virtual vector<T> load(unsigned long first, unsigned int count) override {
+			
+			lock_guard<mutex> guard(lock); 
+			
+			vector<T> tmpdata; 
+			
+			unsigned long j = first / stride; 
+			while(offsets.size() <= j && !indexed) extend(); 
+			if(offsets.size() <= j) return tmpdata; 
+			
+			file.clear(); 
+			file.seekg(offsets[j]); 
+			
+			string stemp; 
+			for(unsigned long skip = first - j * stride; skip > 0; skip--) {
+				if(!getline(file, stemp)) return tmpdata; 
+			}
+			
+			tmpdata.reserve(count); 
+			while(tmpdata.size() < count && getline(file, stemp)) {
+				tmpdata.push_back(parsevalue<T>(stemp)); 
+			}
+			
+			return tmpdata; 
+			
+		}
+		
+		virtual string identity() const override {
+			return "file:" + filename + ":" + modified; 
+		}
+		
+};
+
+template<class T, unsigned int N = 0>
+class RandomAccessSource : public DataSource<T, N> {
+	
+	private:
+		unique_ptr<BlockLoader<T>> loader; 
+		unsigned int blocksize; 
+		string prefix; 
+		
+		//The block in use. 
+		shared_ptr<const vector<T>> current; 
+		unsigned long currentblock; 
+		
+		unsigned long start; 
+		
+		future<void> prefetching; 
+		
+		inline string key(unsigned long k) const {
+			return prefix + std::to_string(k); 
+		}
+		
+		inline shared_ptr<const vector<T>> loadblock(unsigned long k) {
+			return make_shared<const vector<T>>(loader->load(k * blocksize, blocksize + this->getwindowsize() - 1)); 
+		}
+		
+		inline shared_ptr<const vector<T>> block(unsigned long k) {
+			
+			auto b = BlockCache::instance().find<T>(key(k)); 
+			
+			//Past the end of the data there is nothing worth keeping, and the 
+			//data may yet grow. 
+			if(!b) {
+				b = loadblock(k); 
+				if(!b->empty()) BlockCache::instance().insert<T>(key(k), b); 
+			}
+			
+			return b; 
+			
+		}
+		
+		//Load the neighbours of block k in the background, if they aren't 
+		//cached and we aren't still busy with the last lot. 
+		inline void prefetch(unsigned long k) {
+			
+			if(prefetching.valid() && prefetching.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return; 
+			
+			vector<unsigned long> wanted; 
+			if(!BlockCache::instance().contains(key(k + 1))) wanted.push_back(k + 1); 
+			if(k > 0 && !BlockCache::instance().contains(key(k - 1))) wanted.push_back(k - 1); 
+			
+			if(wanted.empty()) return; 
+			
+			prefetching = async(launch::async, [this, wanted]() {
+				for(auto k : wanted) {
+					auto b = this->loadblock(k); 
+					if(!b->empty()) BlockCache::instance().insert<T>(this->key(k), b); 
+				}
+			});
+			
+		}
+		
+		inline void setup(unsigned int _blocksize) {
+			
+			blocksize = (_blocksize == 0) ? std::max(4 * this->getwindowsize(), 4096u) : _blocksize; 
+			
+			prefix = loader->identity() + ":" + typeid(T).name() + ":" 
+				+ std::to_string(blocksize) + "+" + std::to_string(this->getwindowsize() - 1) + ":"; 
+			
+		}
+
+	public:
+		//blocksize is the number of windows in each block; 0 picks one. 
+		RandomAccessSource(unique_ptr<BlockLoader<T>> _loader, unsigned int _windowsize, unsigned int _blocksize = 0) : 
+			DataSource<T, N>(_windowsize), 
+			loader(move(_loader)), 
+			current(), 
+			currentblock(0), 
+			start(0), 
+			prefetching() 
+		{
+			setup(_blocksize); 
+		}
+		
+		RandomAccessSource(string _filename, unsigned int _windowsize, unsigned int _blocksize = 0) : 
+			DataSource<T, N>(_windowsize), 
+			loader(new FileBlockLoader<T>(_filename)), 
+			current(), 
+			currentblock(0), 
+			start(0), 
+			prefetching() 
+		{
+			setup(_blocksize); 
+		}
+		
+		RandomAccessSource(RandomAccessSource<T, N> const & cpy) = delete; 
+		RandomAccessSource<T, N>& operator =(const RandomAccessSource<T, N>& cpy) = delete; 
+		
+		//Moving is fine, once the background loads (which refer to the old 
+		//object) are done. 
+		RandomAccessSource(RandomAccessSource<T, N> && mv) : 
+			DataSource<T, N>(mv.windowsize), 
+			loader(), 
+			blocksize(mv.blocksize), 
+			prefix(), 
+			current(), 
+			currentblock(mv.currentblock), 
+			start(mv.start), 
+			prefetching() 
+		{
+			if(mv.prefetching.valid()) mv.prefetching.wait(); 
+			loader = move(mv.loader); 
+			prefix = move(mv.prefix); 
+			current = move(mv.current); 
+		}
+		RandomAccessSource<T, N>& operator =(RandomAccessSource<T, N> && mv) = delete; 
+		
+		~RandomAccessSource() {
+			if(prefetching.valid()) prefetching.wait(); 
+		}
+		
+		//A pointer to the window starting at element i. 
+		T * windowat(unsigned long i) {
+			
+			unsigned long k = i / blocksize; 
+			unsigned int offset = i % blocksize; 
+			
+			if(!current || k != currentblock) {
+				current = block(k); 
+				currentblock = k; 
+				prefetch(k); 
+			}
+			
+			if(current->size() < offset + this->getwindowsize()) throw RandomAccessOutOfRangeException(); 
+			
+			return const_cast<T *>(current->data()) + offset; 
+			
+		}
+		
+		//Is there a window starting at element i? 
+		bool haswindow(unsigned long i) {
+			try {
+				windowat(i); 
+				return true; 
+			}
+			catch(RandomAccessOutOfRangeException & e) {
+				return false; 
+			}
+		}
+    
+		//get a pointer to the start of the window
+		T * get() { return windowat(start); }
+		
+		//increment the start pointer
+		void tick() { start++; }
+		
+		//check that the window is still valid
+		bool eods() { return !haswindow(start); }
+		
+		//Restoring is just a lookup. 
+		SourceCheckpoint checkpoint() { 
+			return SourceCheckpoint(CheckpointKind::randomaccess, this->getwindowsize(), start); 
+		}
+		
+		void restore(const SourceCheckpoint & cp) { 
+			cp.expect(CheckpointKind::randomaccess, this->getwindowsize()); 
+			start = cp.index; 
+		}
+		
+};
+
+}
+
+#endif
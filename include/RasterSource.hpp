@@ -0,0 +1,358 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+Sliding two dimensional windows over a raster (an image, a spectrogram, any 
+grid stored a row at a time) too big to hold in memory. 
+
+The window is a patch of rows x cols. Each tick() moves it xstep to the 
+right; once it would run off the right hand edge it goes back to the left 
+and down ystep, and when it would run off the bottom the data has ended. 
+Only whole patches are given. 
+
+Rows are read in strips by a RasterLoader (RawRasterLoader for binary files, 
+TextRasterLoader for one row per line), and the next strip is read in the 
+background while the current ones are in use, as in AsyncIOImpl. Rows above 
+the patch are dropped as it moves down, so no more than rows + strip rows 
+are held, plus the strip on its way. 
+
+get() points at the top left of the patch; the element at (r, c) is at 
+get()[r * getpitch() + c], where the pitch is the width of the raster. This 
+is the layout gsl_matrix_view_array_with_tda(get(), rows, cols, getpitch()) 
+expects. 
+
+*/
+
+#ifndef RasterSource_HEADER
+#define RasterSource_HEADER
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <future>
+#include <utility>
+#include <algorithm>
+#include <exception>
+
+using std::string;
+using std::vector;
+using std::ifstream;
+using std::stringstream; 
+using std::unique_ptr;
+using std::future;
+using std::async;
+using std::launch;
+using std::move;
+using std::exception; 
+
+namespace libsim 
+{
+
+class RasterSourceInvalidException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "no patch available, or a patch that doesn't fit the raster";
+	}
+	
+};
+
+template<class T>
+class RasterLoader {
+	
+	public:
+		virtual ~RasterLoader() {}
+		
+		//the number of elements in a row 
+		virtual size_t getwidth() const = 0; 
+		
+		//Read the next rows rows into out, and return how many were read; 
+		//fewer only at the end of the data. 
+		virtual size_t load(T * out, size_t rows) = 0; 
+		
+};
+
+//Rows of width elements of T, as they are in memory, one after another, 
+//after a header of offset bytes. 
+template<class T>
+class RawRasterLoader : public RasterLoader<T> {
+	
+	private:
+		ifstream file; 
+		size_t width; 
+	
+	public:
+		RawRasterLoader(string filename, size_t _width, std::streamoff offset = 0) : file(filename, std::ios::binary), width(_width) {
+			file.seekg(offset); 
+		}
+		
+		RawRasterLoader(RawRasterLoader<T> const & cpy) = delete; 
+		RawRasterLoader<T>& operator =(const RawRasterLoader<T>& cpy) = delete; 
+		
+		virtual size_t getwidth() const override { return width; }
+		
+		virtual size_t load(T * out, size_t rows) override {
+			file.read(reinterpret_cast<char *>(out), rows * width * sizeof(T)); 
+			return file.gcount() / (width * sizeof(T)); 
+		}
+		
+};
+
+//One row per line, the values separated by whitespace or commas. The width 
+//is that of the first row; blank lines are skipped, and the data ends at a 
+//row of any other width. 
+template<class T>
+class TextRasterLoader : public RasterLoader<T> {
+	
+	private:
+		ifstream file; 
+		vector<T> row; 
+		size_t width; 
+		
+		inline bool readrow() {
+			
+			string stemp; 
+			
+			while(getline(file, stemp)) {
+				
+				std::replace(stemp.begin(), stemp.end(), ',', ' '); 
+				
+				stringstream ss(stemp); 
+				row.clear(); 
+				T v; 
+				while(ss >> v) row.push_back(v); 
+				
+				if(!row.empty()) return true; 
+				
+			}
+			
+			return false; 
+			
+		}
+	
+	public:
+		TextRasterLoader(string filename) : file(filename), row(), width(0) {
+			if(readrow()) width = row.size(); 
+		}
+		
+		TextRasterLoader(TextRasterLoader<T> const & cpy) = delete; 
+		TextRasterLoader<T>& operator =(const TextRasterLoader<T>& cpy) = delete; 
+		
+		virtual size_t getwidth() const override { return width; }
+		
+		virtual size_t load(T * out, size_t rows) override {
+			
+			size_t n = 0; 
+			
+			//The row in hand was read by the constructor or the last load. 
+			while(n < rows && width > 0 && row.size() == width) {
+				std::copy(row.begin(), row.end(), out + n * width); 
+				n++; 
+				if(!readrow()) row.clear(); 
+			}
+			
+			return n; 
+			
+		}
+		
+};
+
+template<class T>
+class RasterSource {
+	
+	private:
+		struct Strip {
+			vector<T> values; 
+			size_t rows; 
+		};
+	
+		unique_ptr<RasterLoader<T>> loader; 
+		const size_t width; 
+		const unsigned int rows; 
+		const unsigned int cols; 
+		const unsigned int xstep; 
+		const unsigned int ystep; 
+		const unsigned int strip; 
+		
+		//The rows held, from row top down. 
+		vector<T> buffer; 
+		size_t top; 
+		size_t held; 
+		
+		//The top left of the patch. 
+		size_t x; 
+		size_t y; 
+		
+		future<Strip> next; 
+		bool exhausted; 
+		bool done; 
+		
+		inline void prefetch() {
+			
+			RasterLoader<T> * l = loader.get(); 
+			size_t n = strip; 
+			size_t w = width; 
+			
+			next = async(launch::async, [l, n, w]() {
+				Strip s; 
+				s.values.resize(n * w); 
+				s.rows = l->load(s.values.data(), n); 
+				s.values.resize(s.rows * w); 
+				return s; 
+			});
+			
+		}
+		
+		//Take the prefetched strip, and start on the one after. False if 
+		//there was nothing left. 
+		inline bool more() {
+			
+			if(exhausted) return false; 
+			
+			Strip s = next.get(); 
+			
+			if(s.rows < strip) exhausted = true; 
+			else prefetch(); 
+			
+			if(s.rows == 0) return false; 
+			
+			buffer.insert(buffer.end(), s.values.begin(), s.values.end()); 
+			held += s.rows; 
+			
+			return true; 
+			
+		}
+		
+		//Drop the rows above the patch, and read until the patch is held. 
+		inline void settle() {
+			
+			while(true) {
+				
+				size_t drop = std::min(y - top, held); 
+				if(drop > 0) {
+					buffer.erase(buffer.begin(), buffer.begin() + drop * width); 
+					top += drop; 
+					held -= drop; 
+				}
+				
+				if(top + held >= y + rows) return; 
+				
+				if(!more()) {
+					done = true; 
+					return; 
+				}
+				
+			}
+			
+		}
+		
+	public:
+		RasterSource(unique_ptr<RasterLoader<T>> _loader, unsigned int _rows, unsigned int _cols, unsigned int _xstep = 1, unsigned int _ystep = 1, unsigned int _strip = 0) : 
+			loader(move(_loader)), 
+			width(loader->getwidth()), 
+			rows(_rows), 
+			cols(_cols), 
+			xstep(_xstep), 
+			ystep(_ystep), 
+			strip(_strip == 0 ? _rows : _strip), 
+			buffer(), 
+			top(0), 
+			held(0), 
+			x(0), 
+			y(0), 
+			next(), 
+			exhausted(false), 
+			done(false) 
+		{
+			
+			if(rows == 0 || cols == 0 || xstep == 0 || ystep == 0 || cols > width) throw RasterSourceInvalidException(); 
+			
+			buffer.reserve((rows + strip) * width); 
+			
+			prefetch(); 
+			settle(); 
+			
+		}
+		
+		//A raw binary raster. 
+		RasterSource(string filename, size_t _width, unsigned int _rows, unsigned int _cols, unsigned int _xstep = 1, unsigned int _ystep = 1) : 
+			RasterSource(unique_ptr<RasterLoader<T>>(new RawRasterLoader<T>(filename, _width)), _rows, _cols, _xstep, _ystep) {}
+		
+		RasterSource(RasterSource<T> const & cpy) = delete; 
+		RasterSource<T>& operator =(const RasterSource<T>& cpy) = delete; 
+		
+		//Moving is fine: the prefetch only holds the loader, which stays put.
+		//Assigning would free our loader while our prefetch may be using it. 
+		RasterSource(RasterSource<T> && mv) = default; 
+		RasterSource<T>& operator =(RasterSource<T> && mv) = delete; 
+		
+		~RasterSource() {
+			if(next.valid()) next.wait(); 
+		}
+		
+		//the top left of the patch; rows are getpitch() elements apart 
+		T * get() {
+			if(done) throw RasterSourceInvalidException(); 
+			return buffer.data() + (y - top) * width + x; 
+		}
+		
+		inline size_t getpitch() const { return width; }
+		inline unsigned int getrows() const { return rows; }
+		inline unsigned int getcols() const { return cols; }
+		
+		//where the patch is in the raster 
+		inline size_t getx() const { return x; }
+		inline size_t gety() const { return y; }
+		
+		//the rows held in memory, not counting the strip being read 
+		inline size_t getheld() const { return held; }
+		
+		void tick() {
+			
+			if(done) return; 
+			
+			if(x + xstep + cols <= width) {
+				x += xstep; 
+				return; 
+			}
+			
+			x = 0; 
+			y += ystep; 
+			
+			settle(); 
+			
+		}
+		
+		bool eods() { return done; }
+		
+};
+
+}
+
+#endif
@@ -27,6 +27,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 /* 
 This class implements a window over a ring. It operates over a vector for now. 
+
+The first windowsize - 1 elements are mirrored after the end of the vector, so 
+every window (including those that wrap around) is a contiguous run of the same 
+buffer and get() never has to decide between the data and a patch. The ring is 
+allocated with a PageAllocator, so it follows MemoryPolicy::getdefault(). 
 */
 
 #ifndef RingSource_HEADER
@@ -34,8 +39,10 @@ This class implements a window over a ring. It operates over a vector for now.
 
 #include <vector>
 #include <utility>
+#include <algorithm>
 
 #include "DataSource.hpp"
+#include "PageAllocator.hpp"
 
 using std::vector;
 using std::move; 
@@ -51,58 +58,81 @@ class RingSourceInvalidException : public exception {
 	
 };
 	
-template<class T>
-class RingSource : public DataSource<T> {
+template<class T, unsigned int N = 0>
+class RingSource : public DataSource<T, N> {
 	
 	private:
-		vector<T> data;
-		vector<T> patch; 
+		vector<T, PageAllocator<T>> data;
+		unsigned int size; 
 		unsigned int start; 
-
-	public:
-		RingSource(vector<T> _data, unsigned int _windowsize) : 
-			DataSource<T>(_windowsize), 
-			data(_data), 
-			patch(),
-			start(0) 
-		{
+	
+		inline void mirror(const vector<T> & values) {
 			
-			if(_windowsize > data.size()) throw RingSourceInvalidException();
+			if(this->getwindowsize() > size) throw RingSourceInvalidException();
 			
-			patch.reserve((_windowsize - 1) * 2);
+			data.reserve(size + this->getwindowsize() - 1); 
+			data.assign(values.begin(), values.end()); 
 			
-			patch.insert(patch.begin(), data.end() - (_windowsize - 1) , data.end());
-			patch.insert(patch.end(), data.begin(), data.begin() + (_windowsize - 1));
+			for(unsigned int i = 0; i + 1 < this->getwindowsize(); i++) {
+				data.push_back(data[i]); 
+			}
 			
 		}
+
+	public:
+		RingSource(const vector<T> & _data, unsigned int _windowsize) : 
+			DataSource<T, N>(_windowsize), 
+			data(), 
+			size(_data.size()),
+			start(0) 
+		{
+			mirror(_data);
+		}
+		
+		//Only for a compile-time windowsize
+		RingSource(const vector<T> & _data) : 
+			DataSource<T, N>(), 
+			data(), 
+			size(_data.size()),
+			start(0) 
+		{
+			mirror(_data);
+		}
 		
-		RingSource(RingSource<T> const & cpy) = delete; 
-		RingSource<T>& operator =(const RingSource<T>& cpy) = delete; 
+		RingSource(RingSource<T, N> const & cpy) = delete; 
+		RingSource<T, N>& operator =(const RingSource<T, N>& cpy) = delete; 
 	
 		//Moving is fine, so support rvalue move and move assignment operators.
-		RingSource(RingSource<T> && mv) : DataSource<T>(mv.windowsize), data(move(mv.data)), patch(move(mv.patch)), start(mv.start) {}
-		RingSource<T>& operator =(RingSource<T> && mv) { data = move(mv.data); data = move(mv.patch); start = mv.start; return *this; }
+		RingSource(RingSource<T, N> && mv) : DataSource<T, N>(mv.windowsize), data(move(mv.data)), size(mv.size), start(mv.start) {}
+		RingSource<T, N>& operator =(RingSource<T, N> && mv) { data = move(mv.data); size = mv.size; start = mv.start; return *this; }
 		~RingSource() = default; 
     
 		//get a pointer to the start of the window
 		T * get()  {
-			
-			unsigned int m = start % data.size(); 
-			
-			if(m <  (data.size() - (DataSource<T>::windowsize - 1))) {
-				//we're on the main data. 
-				return data.data() + m; 
-			}
-			else {
-				//we're on the patch. 
-				unsigned int idx = m - (data.size() - (DataSource<T>::windowsize - 1)); 
-				return patch.data() + idx; 
-			}
-			
+			return data.data() + start;
 		}
 		
-		//increment the start pointer
-		void tick() { start++; }
+		//increment the start pointer, wrapping at the end of the ring rather
+		//than taking a modulo on every get(). 
+		void tick() { 
+			start++; 
+			if(start == size) start = 0; 
+		}
+		
+		//The windows up to the end of the ring are contiguous; those after 
+		//that start again from the beginning. 
+		WindowBatch<T> batch(unsigned int k) { 
+			return WindowBatch<T>(get(), std::min(k, size - start), this->getwindowsize()); 
+		}
+		
+		SourceCheckpoint checkpoint() { 
+			return SourceCheckpoint(CheckpointKind::ring, this->getwindowsize(), start); 
+		}
+		
+		void restore(const SourceCheckpoint & cp) { 
+			cp.expect(CheckpointKind::ring, this->getwindowsize()); 
+			start = cp.index % size; 
+		}
 		
 		//check that the window is still valid. This is always with a ring source.
 		bool eods() { return false;  }
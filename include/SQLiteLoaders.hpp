@@ -0,0 +1,183 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+Loaders that read from SQLite for the sources that take one: samples for a 
+TimeWindowSource and blocks for a RandomAccessSource. They are kept apart from 
+SQLiteSource.hpp so that code that only wants an SQLiteSource doesn't pull in 
+those sources as well. 
+
+*/
+
+#ifndef SQLiteLoaders_HEADER
+#define SQLiteLoaders_HEADER
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <mutex>
+#include <atomic>
+#include <sqlite3.h>
+
+#include "SQLiteSource.hpp"
+#include "RandomAccessSource.hpp"
+#include "TimeWindowSource.hpp"
+
+using std::string;
+using std::vector;
+using std::stringstream; 
+using std::mutex;
+using std::lock_guard;
+using std::atomic; 
+
+namespace libsim 
+{
+
+//Samples for a TimeWindowSource. The query returns the timestamp in the first 
+//column and the value in the second, in time order, and has the same 
+//"LIMIT ? OFFSET ?" requirement as SQLiteSource. 
+template <class T>
+class TimedSQLiteLoader : public TimedLoader<T> {
+	
+	private:
+		sqlite3 * const db;
+		sqlite3_stmt * statement;
+		const string query; 
+		unsigned long offset; 
+		
+	public:
+		TimedSQLiteLoader(sqlite3 * _db, string _query) : db(_db), statement(nullptr), query(_query), offset(0) {
+			
+			int result = sqlite3_prepare_v2(db, query.c_str(), -1, &statement, 0);	
+			if(result != SQLITE_OK && result != SQLITE_DONE) throw SQLiteSourceInvalidException();
+			
+		}
+		
+		TimedSQLiteLoader(TimedSQLiteLoader<T> const & cpy) = delete; 
+		TimedSQLiteLoader<T>& operator =(const TimedSQLiteLoader<T>& cpy) = delete; 
+		
+		~TimedSQLiteLoader() {
+			sqlite3_finalize(statement);
+		}
+		
+		virtual size_t load(vector<double> & times, vector<T> & values, size_t count) override {
+			
+			size_t n = 0; 
+			
+			sqlite3_bind_int(statement, 1, count);
+			sqlite3_bind_int64(statement, 2, offset);
+			
+			while(n < count && sqlite3_step(statement) == SQLITE_ROW) {
+				times.push_back(sqlite3_column_double(statement, 0)); 
+				values.push_back(sqlitevalue<T>(statement, 1)); 
+				n++; 
+			}
+			
+			sqlite3_reset(statement);
+			offset += n; 
+			
+			return n; 
+			
+		}
+		
+};
+
+//Blocks for a RandomAccessSource. The query has the same "LIMIT ? OFFSET ?" 
+//requirement as SQLiteSource. 
+template <class T>
+class SQLiteBlockLoader : public BlockLoader<T> {
+	
+	private:
+		sqlite3 * const db;
+		sqlite3_stmt * statement;
+		const string query; 
+		mutex lock; 
+		
+		//Which database this is, and which version of it: the file and its 
+		//write-ahead log as they were when we were made, or for a database 
+		//with no file, a number no other loader gets. 
+		string source; 
+		string generation; 
+		
+		static unsigned long nextgeneration() {
+			static atomic<unsigned long> generations(0); 
+			return generations++; 
+		}
+		
+	public:
+		SQLiteBlockLoader(sqlite3 * _db, string _query) : db(_db), statement(nullptr), query(_query), lock(), source(), generation() {
+			
+			int result = sqlite3_prepare_v2(db, query.c_str(), -1, &statement, 0);	
+			if(result != SQLITE_OK && result != SQLITE_DONE) throw SQLiteSourceInvalidException();
+			
+			const char * filename = sqlite3_db_filename(db, "main"); 
+			if(filename != nullptr) source = filename; 
+			
+			if(source.empty()) generation = "#" + std::to_string(nextgeneration()); 
+			else generation = BlockLoader<T>::version(source) + "+" + BlockLoader<T>::version(source + "-wal"); 
+			
+		}
+		
+		SQLiteBlockLoader(SQLiteBlockLoader<T> const & cpy) = delete; 
+		SQLiteBlockLoader<T>& operator =(const SQLiteBlockLoader<T>& cpy) = delete; 
+		
+		~SQLiteBlockLoader() {
+			sqlite3_finalize(statement);
+		}
+		
+		virtual vector<T> load(unsigned long first, unsigned int count) override {
+			
+			lock_guard<mutex> guard(lock); 
+			
+			auto tmpdata = vector<T>();
+			tmpdata.reserve(count);
+			
+			sqlite3_bind_int(statement, 1, count);
+			sqlite3_bind_int64(statement, 2, first);
+			
+			while(tmpdata.size() < count && sqlite3_step(statement) == SQLITE_ROW) {
+				tmpdata.push_back(sqlitevalue<T>(statement)); 
+			}
+			
+			sqlite3_reset(statement);
+			
+			return tmpdata; 
+			
+		}
+		
+		virtual string identity() const override {
+			stringstream ss; 
+			ss << "sqlite:" << source << ":" << generation << ":" << query; 
+			return ss.str(); 
+		}
+		
+};
+
+}
+
+#endif
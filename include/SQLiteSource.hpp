@@ -49,6 +49,7 @@ drop table, you can, and it'll run it.
 #include <sqlite3.h>
 
 #include "DataSource.hpp"
+#include "AsyncIOImpl.hpp"
 
 using std::string;
 using std::unique_ptr; 
@@ -76,73 +77,104 @@ class SQLiteSourceInvalidException : public exception {
 	
 };
 	
+//A column (the first, unless told otherwise) of the current row. 
 template <class T>
+inline T sqlitevalue(sqlite3_stmt * statement, int column = 0);
+
+template <>
+inline double sqlitevalue<double>(sqlite3_stmt * statement, int column) {
+	return sqlite3_column_double(statement, column);
+}
+
+template <>
+inline unsigned int sqlitevalue<unsigned int>(sqlite3_stmt * statement, int column) {
+	return (unsigned int) sqlite3_column_int(statement, column);
+}
+
+template <class T, unsigned int N = 0>
 class SQLiteSourceImpl;
 	
-template <class T>
-class SQLiteSource : public DataSource<T> {
+template <class T, unsigned int N = 0>
+class SQLiteSource : public DataSource<T, N> {
 	
 	private:
-		unique_ptr<SQLiteSourceImpl<T>> impl;
+		unique_ptr<SQLiteSourceImpl<T, N>> impl;
 	
 	public:
-		SQLiteSource(sqlite3 * _db, string _query, unsigned int _windowsize, launch _policy, int _datapoints) : DataSource<T>(_windowsize)
+		SQLiteSource(sqlite3 * _db, string _query, unsigned int _windowsize, launch _policy, int _datapoints) : DataSource<T, N>(_windowsize)
 		{
-			impl = unique_ptr<SQLiteSourceImpl<T>>(new SQLiteSourceImpl<T>(_db, _query, _windowsize, _datapoints));
+			impl = unique_ptr<SQLiteSourceImpl<T, N>>(new SQLiteSourceImpl<T, N>(_db, _query, _windowsize, _policy, _datapoints));
 		}
 		
-		SQLiteSource(sqlite3 * _db, string _query, unsigned int _windowsize, int _datapoints) : DataSource<T>(_windowsize)
+		SQLiteSource(sqlite3 * _db, string _query, unsigned int _windowsize, int _datapoints) : DataSource<T, N>(_windowsize)
 		{
-			impl = unique_ptr<SQLiteSourceImpl<T>>(new SQLiteSourceImpl<T>(_db, _query, _windowsize, launch::deferred, _datapoints));
+			impl = unique_ptr<SQLiteSourceImpl<T, N>>(new SQLiteSourceImpl<T, N>(_db, _query, _windowsize, launch::deferred, _datapoints));
 		}
 			
-		SQLiteSource(sqlite3 * _db, string _query, unsigned int _windowsize, launch _policy) : DataSource<T>(_windowsize)
+		SQLiteSource(sqlite3 * _db, string _query, unsigned int _windowsize, launch _policy) : DataSource<T, N>(_windowsize)
 		{
-			impl = unique_ptr<SQLiteSourceImpl<T>>(new SQLiteSourceImpl<T>(_db, _query, _policy, numeric_limits<unsigned int>::max()));
+			impl = unique_ptr<SQLiteSourceImpl<T, N>>(new SQLiteSourceImpl<T, N>(_db, _query, _windowsize, _policy, numeric_limits<unsigned int>::max()));
 		}
 
-		SQLiteSource(sqlite3 * _db, string _query, unsigned int _windowsize) : DataSource<T>(_windowsize)
+		SQLiteSource(sqlite3 * _db, string _query, unsigned int _windowsize) : DataSource<T, N>(_windowsize)
 		{
-			impl = unique_ptr<SQLiteSourceImpl<T>>(new SQLiteSourceImpl<T>(_db, _query, _windowsize, launch::deferred, numeric_limits<unsigned int>::max()));
+			impl = unique_ptr<SQLiteSourceImpl<T, N>>(new SQLiteSourceImpl<T, N>(_db, _query, _windowsize, launch::deferred, numeric_limits<unsigned int>::max()));
 		}
 		
 		//No copying. That would leave this object in a horrendous state
 		//and I don't want to figure out how to do it. 
-		SQLiteSource(SQLiteSource<T> const & cpy) = delete; 
-		SQLiteSource<T>& operator =(const SQLiteSource<T>& cpy) = delete; 
+		SQLiteSource(SQLiteSource<T, N> const & cpy) = delete; 
+		SQLiteSource<T, N>& operator =(const SQLiteSource<T, N>& cpy) = delete; 
 	
 		//Moving is fine, so support rvalue move and move assignment operators.
-		SQLiteSource(SQLiteSource<T> && mv) : DataSource<T>(mv.windowsize), impl(move(mv.impl)) {}
-		SQLiteSource<T>& operator =(SQLiteSource<T> && mv) { impl = move(mv.impl); return *this; }
+		SQLiteSource(SQLiteSource<T, N> && mv) : DataSource<T, N>(mv.windowsize), impl(move(mv.impl)) {}
+		SQLiteSource<T, N>& operator =(SQLiteSource<T, N> && mv) { impl = move(mv.impl); return *this; }
 		~SQLiteSource() = default; 
 		
 		inline virtual T * get() override { return impl->get(); };
 		inline virtual void tick() override { impl->tock(); };
 		inline virtual bool eods() override { return impl->eods(); };
+		
+		//Abandon the stream early: outstanding io stops at the next element.
+		inline void cancel() { if(impl) impl->cancel(); };
+		
+		//Bounds, in elements, on the adaptive read size. 
+		inline void setreadbounds(unsigned int _min, unsigned int _max) { impl->setreadbounds(_min, _max); };
+		inline size_t getheld() const { return impl->getheld(); };
+		
+		//Without blocking: is a window (or the end of the data) here yet? If 
+		//not, whenready() calls back from the io thread when it might be. 
+		inline bool poll() { return impl->poll(); };
+		inline bool whenready(function<void()> callback) { return impl->whenready(move(callback)); };
+		
+		inline virtual WindowBatch<T> batch(unsigned int k) override { return impl->batch(k); };
+		inline virtual SourceCheckpoint checkpoint() override { return impl->checkpoint(); };
+		inline virtual void restore(const SourceCheckpoint & cp) override { impl->restore(cp); };
 
 };
 
-template<>
-class SQLiteSourceImpl<double> : public AsyncIOImpl<double> {
+template<unsigned int N>
+class SQLiteSourceImpl<double, N> : public AsyncIOImpl<double, N> {
 
 	private:
 		sqlite3 * const db;
 		sqlite3_stmt * statement;
 	
-		virtual vector<double> ioinit() override { 
+		inline vector<double> load() {
 			
 			auto tmpdata = vector<double>();
 			tmpdata.reserve(this->read_extent);
 			
 			unsigned int i = 0;
 			
-			sqlite3_bind_int(statement, 1, this->windowsize * 3);
+			sqlite3_bind_int(statement, 1, this->read_extent);
 			sqlite3_bind_int(statement, 2, this->datapoints_read);
 
 			int res = sqlite3_step(statement);
 			
 			for( ; i < this->read_extent; i++)  {
 				if(this->datapoints_read == this->datapoints_limit) break; 
+				if(this->cancelled) break;
 				if(res != SQLITE_ROW) break;
 				
 				double temp; 
@@ -164,93 +196,73 @@ class SQLiteSourceImpl<double> : public AsyncIOImpl<double> {
 			
 		}
 		
-		virtual vector<double> ionext() override {
-		
-			//Create andconfigure the 
-			//return
-			auto tmpdata = vector<double>();
-			tmpdata.reserve(this->windowsize);
-			
-			//Now the load
-			
-			unsigned int i = 0; 
-			
-			sqlite3_bind_int(statement, 1, this->windowsize);
-			sqlite3_bind_int(statement, 2, this->datapoints_read);
-			
-			int res = sqlite3_step(statement);
-			
-			for( ; i < this->windowsize; i++)  {
-				if(this->datapoints_read == this->datapoints_limit) break; 
-				if(res != SQLITE_ROW) break;
-				
-				double temp; 
-				
-				temp = sqlite3_column_double(statement, 0);
-				
-				tmpdata.push_back(temp);
-				
-				this->datapoints_read++;
-				
-				res = sqlite3_step(statement);
-			}
-			
-			sqlite3_reset(statement);
-			
-			this->readyio = true; 
-			
-			return tmpdata;
-			
-		}
-	
+		virtual vector<double> ioinit() override { return load(); }
+		virtual vector<double> ionext() override { return load(); }
 		
 	public:
 		SQLiteSourceImpl(sqlite3 * _db, string _query, unsigned int _wsize, launch _policy, unsigned int datapoints) :
-			AsyncIOImpl<double>(_wsize, _policy, datapoints),
+			AsyncIOImpl<double, N>(_wsize, _policy, datapoints),
 			db(_db) 
 		{
 			
 			int result = sqlite3_prepare_v2(db, _query.c_str(), -1, &statement, 0);	
 			if(result != SQLITE_OK && result != SQLITE_DONE) throw -1;
+			
+			this->prime();
 
 		}
 		
 		//Absolutely no copying. _
-		SQLiteSourceImpl(SQLiteSourceImpl<double> const & cpy) = delete; 
-		SQLiteSourceImpl<double>& operator =(const SQLiteSourceImpl<double>& cpy) = delete; 
+		SQLiteSourceImpl(SQLiteSourceImpl<double, N> const & cpy) = delete; 
+		SQLiteSourceImpl<double, N>& operator =(const SQLiteSourceImpl<double, N>& cpy) = delete; 
 		
-		SQLiteSourceImpl(SQLiteSourceImpl<double> && mv) = delete; 
-		SQLiteSourceImpl<double>& operator =(SQLiteSourceImpl<double> && mv) = delete; 
+		SQLiteSourceImpl(SQLiteSourceImpl<double, N> && mv) = delete; 
+		SQLiteSourceImpl<double, N>& operator =(SQLiteSourceImpl<double, N> && mv) = delete; 
 		~SQLiteSourceImpl() {
 			
+			//Stop the io before the statement goes away underneath it. 
+			this->cancel();
+			
 			sqlite3_finalize(statement);
 			
 		}			
 		
+		//The query is positioned by its OFFSET, so only the index is needed. 
+		SourceCheckpoint checkpoint() {
+			return SourceCheckpoint(CheckpointKind::sqlite, this->getwindowsize(), this->position); 
+		}
+		
+		void restore(const SourceCheckpoint & cp) {
+			cp.expect(CheckpointKind::sqlite, this->getwindowsize()); 
+			this->settle(); 
+			this->restart(cp.index); 
+		}
+		
 };
 
 
-template<>
-class SQLiteSourceImpl<unsigned int> : public AsyncIOImpl<unsigned int> {
+template<unsigned int N>
+class SQLiteSourceImpl<unsigned int, N> : public AsyncIOImpl<unsigned int, N> {
 
 	private:
 		sqlite3 * const db;
 		sqlite3_stmt * statement;
 	
-		virtual vector<unsigned int> ioinit() override { 
+		inline vector<unsigned int> load() {
 			
 			auto tmpdata = vector<unsigned int>();
 			tmpdata.reserve(this->read_extent);
 			
 			unsigned int i = 0;
 			
-			sqlite3_bind_int(statement, 1, this->windowsize * 3);
+			sqlite3_bind_int(statement, 1, this->read_extent);
 			sqlite3_bind_int(statement, 2, this->datapoints_read);
 			
 			int res = sqlite3_step(statement);
 			
 			for( ; i < this->read_extent; i++)  {
 				if(this->datapoints_read == this->datapoints_limit) break; 
+				if(this->cancelled) break;
 				if(res != SQLITE_ROW) break;
 				
 				unsigned int temp; 
@@ -272,69 +284,48 @@ class SQLiteSourceImpl<unsigned int> : public AsyncIOImpl<unsigned int> {
 			
 		}
 		
-		virtual vector<unsigned int> ionext() override {
-		
-			//Create andconfigure the 
-			//return
-			auto tmpdata = vector<unsigned int>();
-			tmpdata.reserve(this->windowsize);
-			
-			//Now the load
-			
-			unsigned int i = 0; 
-			
-			sqlite3_bind_int(statement, 1, this->windowsize);
-			sqlite3_bind_int(statement, 2, this->datapoints_read);
-			
-			int res = sqlite3_step(statement);
-			
-			for( ; i < this->windowsize; i++)  {
-				if(this->datapoints_read == this->datapoints_limit) break; 
-				if(res != SQLITE_ROW) break;
-				
-				unsigned int temp; 
-				
-				temp = (unsigned int) sqlite3_column_int(statement, 0);
-				
-				tmpdata.push_back(temp);
-				
-				this->datapoints_read++;
-				
-				res = sqlite3_step(statement);
-			}
-			
-			sqlite3_reset(statement);
-			
-			this->readyio = true; 
-			
-			return tmpdata;
-			
-		}
-	
+		virtual vector<unsigned int> ioinit() override { return load(); }
+		virtual vector<unsigned int> ionext() override { return load(); }
 		
 	public:
 		SQLiteSourceImpl(sqlite3 * _db, string _query, unsigned int _wsize, launch _policy, unsigned int datapoints) :
-			AsyncIOImpl<unsigned int>(_wsize, _policy, datapoints),
+			AsyncIOImpl<unsigned int, N>(_wsize, _policy, datapoints),
 			db(_db) 
 		{
 			
 			int result = sqlite3_prepare_v2(db, _query.c_str(), -1, &statement, 0);	
 			if(result != SQLITE_OK && result != SQLITE_DONE) throw -1;
+			
+			this->prime();
 
 		}
 		
 		//Absolutely no copying. _
-		SQLiteSourceImpl(SQLiteSourceImpl<unsigned int> const & cpy) = delete; 
-		SQLiteSourceImpl<unsigned int>& operator =(const SQLiteSourceImpl<unsigned int>& cpy) = delete; 
+		SQLiteSourceImpl(SQLiteSourceImpl<unsigned int, N> const & cpy) = delete; 
+		SQLiteSourceImpl<unsigned int, N>& operator =(const SQLiteSourceImpl<unsigned int, N>& cpy) = delete; 
 		
-		SQLiteSourceImpl(SQLiteSourceImpl<unsigned int> && mv) = delete; 
-		SQLiteSourceImpl<unsigned int>& operator =(SQLiteSourceImpl<unsigned int> && mv) = delete; 
+		SQLiteSourceImpl(SQLiteSourceImpl<unsigned int, N> && mv) = delete; 
+		SQLiteSourceImpl<unsigned int, N>& operator =(SQLiteSourceImpl<unsigned int, N> && mv) = delete; 
 		~SQLiteSourceImpl() {
 			
+			//Stop the io before the statement goes away underneath it. 
+			this->cancel();
+			
 			sqlite3_finalize(statement);
 			
 		}			
 		
+		//The query is positioned by its OFFSET, so only the index is needed. 
+		SourceCheckpoint checkpoint() {
+			return SourceCheckpoint(CheckpointKind::sqlite, this->getwindowsize(), this->position); 
+		}
+		
+		void restore(const SourceCheckpoint & cp) {
+			cp.expect(CheckpointKind::sqlite, this->getwindowsize()); 
+			this->settle(); 
+			this->restart(cp.index); 
+		}
+		
 };
 
 
@@ -0,0 +1,113 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+Reads any DataSource as a plain stream of elements, for code that consumes 
+samples rather than windows (transforms, merges). The first window gives the 
+first windowsize elements; after that each tick() brings in exactly one new 
+element, at the end of the window, so every element is read once and none are 
+lost at the end of the data. 
+
+The source is borrowed, not owned, and must outlive the stream. Don't use the 
+source directly while a stream is reading it. 
+
+*/
+
+#ifndef SampleStream_HEADER
+#define SampleStream_HEADER
+
+#include <cstddef>
+
+#include "DataSource.hpp"
+
+using std::size_t; 
+
+namespace libsim 
+{
+
+template<class T>
+class SampleStream {
+	
+	private:
+		DataSource<T> * source; 
+		unsigned int next; 
+		bool done; 
+	
+	public:
+		SampleStream(DataSource<T> & _source) : source(&_source), next(0), done(false) {}
+		
+		SampleStream(SampleStream<T> const & cpy) = delete; 
+		SampleStream<T>& operator =(const SampleStream<T>& cpy) = delete; 
+		
+		SampleStream(SampleStream<T> && mv) = default; 
+		SampleStream<T>& operator =(SampleStream<T> && mv) = default; 
+		~SampleStream() = default; 
+		
+		//Reads up to n elements into out, and returns how many were read; 
+		//fewer than n only at the end of the data. 
+		size_t read(T * out, size_t n) {
+			
+			size_t count = 0; 
+			const unsigned int w = source->getwindowsize(); 
+			
+			while(count < n && !done) {
+				
+				if(next == 0 && source->eods()) {
+					done = true; 
+					break; 
+				}
+				
+				//Still in the first window. 
+				if(next < w) {
+					T * window = source->get(); 
+					while(next < w && count < n) out[count++] = window[next++]; 
+					continue; 
+				}
+				
+				source->tick(); 
+				
+				if(source->eods()) {
+					done = true; 
+					break; 
+				}
+				
+				out[count++] = source->get()[w - 1]; 
+				
+			}
+			
+			return count; 
+			
+		}
+		
+		inline bool finished() const { return done; }
+		
+};
+
+}
+
+#endif
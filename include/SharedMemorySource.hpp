@@ -0,0 +1,391 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+A window over a ring in POSIX shared memory, so that one process can parse a 
+feed once and any number of processes on the same machine can read it. 
+
+The SharedMemoryWriter creates the segment and appends to it. Like RingSource, 
+the first maxwindow - 1 slots of the ring are mirrored after the end, so every 
+window is contiguous. The only coordination is two counts: the elements the 
+writer is about to write, which it publishes before it touches the ring, and 
+the elements written, which it publishes with a release store after the data 
+is in place. Each SharedMemorySource maps the segment read-only and keeps its 
+own cursor against them: it reads up to the second, and has been overrun as 
+soon as the first reaches its window. Nothing is a syscall per sample: a reader that has caught 
+up spins for a while before it starts yielding. 
+
+The writer doesn't wait for readers. A reader that falls more than the ring's 
+capacity behind has lost data, and tick()/get() throw a 
+SharedMemoryOverrunException. Because the writer might lap a reader while it 
+is still using a window, valid() can be called afterwards to check that the 
+window wasn't overwritten in the meantime. 
+
+The pointer returned by get() is into read-only memory: don't write through it.
+
+*/
+
+#ifndef SharedMemorySource_HEADER
+#define SharedMemorySource_HEADER
+
+#include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <exception>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "DataSource.hpp"
+
+using std::string;
+using std::atomic;
+using std::exception; 
+using std::move;
+
+namespace libsim 
+{
+
+class SharedMemoryInvalidException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "shared memory segment could not be opened, or does not match";
+	}
+	
+};
+
+class SharedMemoryOverrunException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "the writer has overwritten the window";
+	}
+	
+};
+
+enum class SharedMemoryStart { oldest, latest };
+
+struct SharedMemoryHeader {
+	
+	static const uint32_t MAGIC = 0x4c535752; 
+	static const uint32_t VERSION = 2; 
+	
+	atomic<uint32_t> magic; 
+	uint32_t version; 
+	uint32_t elementsize; 
+	uint32_t capacity; 
+	uint32_t mirror; 
+	atomic<uint32_t> closed; 
+	
+	//Elements written so far. Everything below this is in place. 
+	alignas(64) atomic<uint64_t> head; 
+	
+	//Elements the writer has started on. Slots for everything below this 
+	//may be being written. 
+	atomic<uint64_t> claimed; 
+	
+	static size_t segmentsize(uint32_t capacity, uint32_t mirror, uint32_t elementsize) {
+		return sizeof(SharedMemoryHeader) + (size_t) (capacity + mirror) * elementsize; 
+	}
+	
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared memory windows need lock-free 64-bit atomics");
+
+template<class T>
+class SharedMemoryWriter {
+	
+	private:
+		string name; 
+		SharedMemoryHeader * header; 
+		T * data; 
+		size_t length; 
+		uint64_t written; 
+		
+		inline void put(T value) {
+			
+			uint32_t idx = written % header->capacity; 
+			
+			data[idx] = value; 
+			if(idx < header->mirror) data[header->capacity + idx] = value; 
+			
+			written++; 
+			
+		}
+		
+		//Say that the next n slots are about to change, before any of them 
+		//does: the fence keeps the writes to the ring after this store. 
+		inline void claim(unsigned int n) {
+			header->claimed.store(written + n, std::memory_order_relaxed); 
+			std::atomic_thread_fence(std::memory_order_release); 
+		}
+		
+	public:
+		//capacity is the number of elements in the ring; readers can use any 
+		//windowsize up to maxwindow. 
+		SharedMemoryWriter(string _name, unsigned int capacity, unsigned int maxwindow) : 
+			name(_name), 
+			header(nullptr), 
+			data(nullptr), 
+			length(0), 
+			written(0) 
+		{
+			
+			if(maxwindow == 0 || maxwindow > capacity) throw SharedMemoryInvalidException(); 
+			
+			length = SharedMemoryHeader::segmentsize(capacity, maxwindow - 1, sizeof(T)); 
+			
+			int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644); 
+			if(fd < 0) throw SharedMemoryInvalidException(); 
+			
+			if(ftruncate(fd, length) != 0) {
+				::close(fd); 
+				shm_unlink(name.c_str()); 
+				throw SharedMemoryInvalidException(); 
+			}
+			
+			void * mem = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0); 
+			::close(fd); 
+			
+			if(mem == MAP_FAILED) {
+				shm_unlink(name.c_str()); 
+				throw SharedMemoryInvalidException(); 
+			}
+			
+			header = new (mem) SharedMemoryHeader(); 
+			header->version = SharedMemoryHeader::VERSION; 
+			header->elementsize = sizeof(T); 
+			header->capacity = capacity; 
+			header->mirror = maxwindow - 1; 
+			header->closed.store(0); 
+			header->head.store(0); 
+			header->claimed.store(0); 
+			
+			data = reinterpret_cast<T *>(header + 1); 
+			
+			//Readers check this last. 
+			header->magic.store(SharedMemoryHeader::MAGIC, std::memory_order_release); 
+			
+		}
+		
+		SharedMemoryWriter(SharedMemoryWriter<T> const & cpy) = delete; 
+		SharedMemoryWriter<T>& operator =(const SharedMemoryWriter<T>& cpy) = delete; 
+		
+		SharedMemoryWriter(SharedMemoryWriter<T> && mv) : name(move(mv.name)), header(mv.header), data(mv.data), length(mv.length), written(mv.written) { mv.header = nullptr; }
+		SharedMemoryWriter<T>& operator =(SharedMemoryWriter<T> && mv) = delete; 
+		
+		//Closes the stream and removes the name; readers that are attached keep
+		//their mapping until they are done. 
+		~SharedMemoryWriter() {
+			
+			if(header == nullptr) return; 
+			
+			close(); 
+			munmap(header, length); 
+			shm_unlink(name.c_str()); 
+			
+		}
+		
+		//Append one value and publish it. 
+		void push_back(T value) {
+			claim(1); 
+			put(value); 
+			header->head.store(written, std::memory_order_release); 
+		}
+		
+		//Append a block of values and publish them together. 
+		void push_back(const T * values, unsigned int n) {
+			claim(n); 
+			for(unsigned int i = 0; i < n; i++) put(values[i]); 
+			header->head.store(written, std::memory_order_release); 
+		}
+		
+		//No more data is coming: readers reach eods() once they've consumed it.
+		void close() {
+			header->closed.store(1, std::memory_order_release); 
+		}
+		
+};
+
+template<class T, unsigned int N = 0>
+class SharedMemorySource : public DataSource<T, N> {
+	
+	private:
+		const SharedMemoryHeader * header; 
+		T * data; 
+		size_t length; 
+		uint64_t cursor; 
+		uint32_t capacity; 
+		
+		//The window at the cursor is lost once the writer has started on the
+		//element a capacity after it, which shares its first slot. 
+		inline bool overrun(uint64_t claimed) const {
+			return claimed > cursor + capacity; 
+		}
+		
+		inline uint64_t getclaimed() const {
+			return header->claimed.load(std::memory_order_acquire); 
+		}
+		
+		//Wait until there's a window at the cursor, or the writer has closed.
+		inline bool wait() {
+			
+			unsigned int spins = 0; 
+			
+			while(true) {
+				
+				uint64_t head = header->head.load(std::memory_order_acquire); 
+				
+				if(overrun(getclaimed())) throw SharedMemoryOverrunException(); 
+				if(cursor + this->getwindowsize() <= head) return true; 
+				
+				if(header->closed.load(std::memory_order_acquire)) {
+					//Check once more: the last data is published before closing.
+					head = header->head.load(std::memory_order_acquire); 
+					return cursor + this->getwindowsize() <= head; 
+				}
+				
+				if(++spins > 1024) std::this_thread::yield(); 
+				
+			}
+			
+		}
+		
+		void attach(string name, SharedMemoryStart from) {
+			
+			int fd = shm_open(name.c_str(), O_RDONLY, 0); 
+			if(fd < 0) throw SharedMemoryInvalidException(); 
+			
+			struct stat st; 
+			if(fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(SharedMemoryHeader)) {
+				::close(fd); 
+				throw SharedMemoryInvalidException(); 
+			}
+			
+			length = st.st_size; 
+			void * mem = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0); 
+			::close(fd); 
+			
+			if(mem == MAP_FAILED) throw SharedMemoryInvalidException(); 
+			
+			header = reinterpret_cast<const SharedMemoryHeader *>(mem); 
+			
+			if(header->magic.load(std::memory_order_acquire) != SharedMemoryHeader::MAGIC 
+				|| header->version != SharedMemoryHeader::VERSION
+				|| header->elementsize != sizeof(T) 
+				|| header->mirror + 1 < this->getwindowsize()
+				|| length < SharedMemoryHeader::segmentsize(header->capacity, header->mirror, sizeof(T))) {
+				munmap(mem, length); 
+				header = nullptr; 
+				throw SharedMemoryInvalidException(); 
+			}
+			
+			capacity = header->capacity; 
+			data = const_cast<T *>(reinterpret_cast<const T *>(header + 1)); 
+			
+			uint64_t head = header->head.load(std::memory_order_acquire); 
+			uint64_t claimed = getclaimed(); 
+			
+			//The oldest window is the one a batch in progress won't overwrite.
+			if(from == SharedMemoryStart::latest) cursor = head; 
+			else cursor = (claimed > capacity) ? claimed - capacity : 0; 
+			
+		}
+
+	public:
+		SharedMemorySource(string _name, unsigned int _windowsize, SharedMemoryStart _from = SharedMemoryStart::oldest) : 
+			DataSource<T, N>(_windowsize), 
+			header(nullptr), 
+			data(nullptr), 
+			length(0), 
+			cursor(0), 
+			capacity(0)
+		{
+			attach(_name, _from); 
+		}
+		
+		SharedMemorySource(SharedMemorySource<T, N> const & cpy) = delete; 
+		SharedMemorySource<T, N>& operator =(const SharedMemorySource<T, N>& cpy) = delete; 
+	
+		//Moving is fine, so support rvalue move.
+		SharedMemorySource(SharedMemorySource<T, N> && mv) : 
+			DataSource<T, N>(mv.windowsize), 
+			header(mv.header), 
+			data(mv.data), 
+			length(mv.length), 
+			cursor(mv.cursor), 
+			capacity(mv.capacity) 
+		{ 
+			mv.header = nullptr; 
+		}
+		SharedMemorySource<T, N>& operator =(SharedMemorySource<T, N> && mv) = delete; 
+		
+		~SharedMemorySource() {
+			if(header != nullptr) munmap(const_cast<SharedMemoryHeader *>(header), length); 
+		}
+    
+		//get a pointer to the start of the window, waiting for it if the writer
+		//hasn't got that far yet. 
+		T * get()  {
+			wait(); 
+			return data + (cursor % capacity);
+		}
+		
+		//increment the start pointer
+		void tick() { 
+			cursor++; 
+			if(overrun(getclaimed())) throw SharedMemoryOverrunException(); 
+		}
+		
+		//check that the window is still valid; waits for the writer.
+		bool eods() { return !wait(); }
+		
+		//True if the current window hasn't been overwritten since get(), and 
+		//isn't being overwritten now. The fence keeps the reads of the window
+		//from moving after the load of claimed, which an acquire load on its 
+		//own doesn't. 
+		inline bool valid() const { 
+			std::atomic_thread_fence(std::memory_order_acquire); 
+			return !overrun(header->claimed.load(std::memory_order_relaxed)); 
+		}
+		
+		//How far behind the writer we are, in elements. 
+		inline uint64_t getlag() const { 
+			return header->head.load(std::memory_order_acquire) - cursor; 
+		}
+		
+};
+
+}
+
+#endif
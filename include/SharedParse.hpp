@@ -0,0 +1,400 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+Sharing one parse of a file between every FileSource reading it. 
+
+Jobs that open FileSources on the same file at the same time would each read 
+and parse the whole of it. Instead, FileSources in snapshot mode look the 
+file up in the ParseRegistry when they are constructed: if another source 
+has a SharedParse of it (by path, size, modification time, element type and 
+datapoint limit) that hasn't yet got past its first chunk, they attach to 
+that one instead of opening the file themselves. This is on unless it is 
+turned off: 
+
+	ParseRegistry::instance().setenabled(false); 
+
+A SharedParse reads the file in chunks as they are first asked for, under 
+its lock, so each line is parsed once however many sources read it. The 
+chunks form a list, linked by shared_ptr from each chunk to the next, and 
+each source holds only the chunk it is reading from: chunks that every source
+has finished with are freed, and the sources move through the list 
+independently, each with its own window, prefetch and buffer. A source that 
+is restored from a checkpoint goes back to reading the file on its own. 
+
+The slowest source holds on to every chunk after it, up to the fastest, so 
+that lag is bounded: once a source is more than maxlag chunks (16 by default)
+behind the newest, the list is cut after the chunk it holds, and when it 
+comes to the end of that chunk it goes back to reading the file on its own 
+from there. The chunks in use are charged to the BufferGovernor, and if it 
+asks for memory back, every source more than a chunk behind is cut loose the 
+same way. 
+
+*/
+
+#ifndef SharedParse_HEADER
+#define SharedParse_HEADER
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+#include <typeinfo>
+#include <utility>
+#include <cstdlib>
+#include <climits>
+#include <sys/stat.h>
+
+#include "BufferGovernor.hpp"
+
+using std::string;
+using std::vector;
+using std::ifstream;
+using std::shared_ptr;
+using std::weak_ptr;
+using std::mutex;
+using std::lock_guard;
+using std::unordered_map;
+using std::move;
+
+namespace libsim 
+{
+
+//In FileSource.hpp. 
+template <class T>
+inline T parsevalue(const string & line); 
+
+template<class T>
+struct ParseChunk {
+	
+	vector<T> values; 
+	//The element, and the byte in the file, that values[0] came from. 
+	unsigned long index; 
+	std::streamoff offset; 
+	shared_ptr<ParseChunk<T>> next; 
+	//Nothing comes after this one. 
+	bool last; 
+	
+	ParseChunk(unsigned long _index, std::streamoff _offset) : values(), index(_index), offset(_offset), next(), last(false) {}
+	
+	//Let go of the chunks after this one a link at a time, rather than by 
+	//recursing down a list that may be very long. Only a chunk we hold the 
+	//one reference to is taken apart; as nothing watches chunks through a 
+	//weak_ptr, nobody else can come to hold it meanwhile. 
+	~ParseChunk() {
+		shared_ptr<ParseChunk<T>> n = move(next); 
+		while(n && n.use_count() == 1) {
+			shared_ptr<ParseChunk<T>> after = move(n->next); 
+			n = move(after); 
+		}
+	}
+	
+};
+
+template<class T>
+class SharedParse {
+	
+	private:
+		ifstream file; 
+		const unsigned int limit; 
+		const size_t chunksize; 
+		unsigned long read; 
+		
+		mutex lock; 
+		
+		//Where new sources start: the empty chunk that tail starts out as, then
+		//the first chunk with data in it, and nowhere once the second has been
+		//read. It is held here rather than watched through a weak_ptr, so that 
+		//no chunk can be revived while ~ParseChunk is taking the list apart. 
+		shared_ptr<ParseChunk<T>> first; 
+		unsigned int produced; 
+		shared_ptr<ParseChunk<T>> tail; 
+		
+		//The chunk each source holds, kept alive by that source, and whether
+		//the list has been cut after it. 
+		struct Cursor {
+			ParseChunk<T> * at; 
+			bool cut; 
+		};
+		unordered_map<unsigned long, Cursor> cursors; 
+		unsigned long nextcursor; 
+		const unsigned int maxlag; 
+		
+		//What the chunks between the slowest source and the newest hold. 
+		const unsigned long account; 
+		
+		inline unsigned long behind(const Cursor & c) const {
+			return read - (c.at->index + c.at->values.size()); 
+		}
+		
+		//Cut the list after every source more than lag elements behind, so 
+		//the chunks only it was keeping can go. 
+		inline void cut(unsigned long lag) {
+			for(auto & it : cursors) {
+				Cursor & c = it.second; 
+				if(c.cut || behind(c) <= lag) continue; 
+				c.at->next.reset(); 
+				c.cut = true; 
+			}
+		}
+		
+		//Settle up with the governor, and give memory back if asked to. 
+		inline void charge() {
+			
+			unsigned long oldest = read; 
+			for(auto & it : cursors) {
+				if(!it.second.cut) oldest = std::min(oldest, it.second.at->index); 
+			}
+			
+			if(BufferGovernor::instance().update(account, (size_t) (read - oldest) * sizeof(T))) {
+				cut(chunksize); 
+				oldest = read; 
+				for(auto & it : cursors) {
+					if(!it.second.cut) oldest = std::min(oldest, it.second.at->index); 
+				}
+				BufferGovernor::instance().update(account, (size_t) (read - oldest) * sizeof(T)); 
+			}
+			
+		}
+		
+		inline void produce() {
+			
+			std::streamoff here = file.tellg(); 
+			
+			shared_ptr<ParseChunk<T>> chunk(new ParseChunk<T>(read, here)); 
+			chunk->values.reserve(chunksize); 
+			
+			string stemp; 
+			while(chunk->values.size() < chunksize && read < limit && getline(file, stemp)) {
+				chunk->values.push_back(parsevalue<T>(stemp)); 
+				read++; 
+			}
+			
+			if(chunk->values.size() < chunksize) chunk->last = true; 
+			
+			if(chunk->values.empty()) {
+				tail->last = true; 
+				return; 
+			}
+			
+			if(++produced == 1) first = chunk; 
+			else first.reset(); 
+			
+			tail->next = chunk; 
+			tail = chunk; 
+			
+			cut((unsigned long) maxlag * chunksize); 
+			charge(); 
+			
+		}
+	
+	public:
+		//maxlag is in chunks, and at least 2, so that nobody is cut while new
+		//sources can still join at the first chunk. 
+		SharedParse(string filename, unsigned int _limit, unsigned int _maxlag = 16, size_t _chunksize = 4096) : 
+			file(filename), limit(_limit), chunksize(_chunksize), read(0), lock(), first(), produced(0), tail(new ParseChunk<T>(0, 0)), 
+			cursors(), nextcursor(0), maxlag(std::max(_maxlag, 2u)), account(BufferGovernor::instance().enroll()) 
+		{
+			first = tail; 
+		}
+		
+		SharedParse(SharedParse<T> const & cpy) = delete; 
+		SharedParse<T>& operator =(const SharedParse<T>& cpy) = delete; 
+		
+		~SharedParse() {
+			BufferGovernor::instance().withdraw(account); 
+		}
+		
+		//Where a new source starts, and its cursor: empty if it's too late to
+		//join. The source must leave() before it lets go of its chunk. 
+		shared_ptr<ParseChunk<T>> start(unsigned long & cursor) { 
+			
+			lock_guard<mutex> guard(lock); 
+			
+			if(first) {
+				cursor = nextcursor++; 
+				cursors[cursor] = Cursor{first.get(), false}; 
+			}
+			
+			return first; 
+			
+		}
+		
+		//The chunk after this one, read now if nobody has yet; empty at the 
+		//end of the data, or if the list has been cut after it. 
+		shared_ptr<ParseChunk<T>> next(const shared_ptr<ParseChunk<T>> & chunk, unsigned long cursor) {
+			
+			lock_guard<mutex> guard(lock); 
+			
+			if(!chunk->next && !chunk->last && !cursors[cursor].cut) produce(); 
+			
+			shared_ptr<ParseChunk<T>> n = chunk->next; 
+			if(n) cursors[cursor].at = n.get(); 
+			
+			return n; 
+			
+		}
+		
+		//Has this source fallen so far behind that it should read on alone? 
+		bool wascut(unsigned long cursor) {
+			lock_guard<mutex> guard(lock); 
+			return cursors[cursor].cut; 
+		}
+		
+		void leave(unsigned long cursor) {
+			lock_guard<mutex> guard(lock); 
+			cursors.erase(cursor); 
+			charge(); 
+		}
+		
+};
+
+class ParseRegistry {
+	
+	private:
+		mutex lock; 
+		unordered_map<string, weak_ptr<void>> producers; 
+		bool enabled; 
+		unsigned int maxlag; 
+		unsigned long shared; 
+		unsigned long detached; 
+		
+		ParseRegistry() : lock(), producers(), enabled(true), maxlag(16), shared(0), detached(0) {}
+		
+		//Empty if the file can't be found, so that it isn't shared. 
+		template<class T>
+		static string key(const string & filename, unsigned int limit) {
+			
+			char path[PATH_MAX]; 
+			struct stat info; 
+			
+			if(realpath(filename.c_str(), path) == nullptr || stat(path, &info) != 0) return string(); 
+			
+			return string(typeid(T).name()) + '\n' + path + '\n' + std::to_string(info.st_size) + '\n' 
+				+ std::to_string(info.st_mtim.tv_sec) + '.' + std::to_string(info.st_mtim.tv_nsec) + '\n' + std::to_string(limit); 
+			
+		}
+		
+	public:
+		ParseRegistry(ParseRegistry const & cpy) = delete; 
+		ParseRegistry& operator =(const ParseRegistry& cpy) = delete; 
+		
+		static ParseRegistry & instance() {
+			static ParseRegistry registry; 
+			return registry; 
+		}
+		
+		//On by default; sources made while it is off read the file themselves.
+		void setenabled(bool _enabled) {
+			lock_guard<mutex> guard(lock); 
+			enabled = _enabled; 
+		}
+		
+		bool isenabled() {
+			lock_guard<mutex> guard(lock); 
+			return enabled; 
+		}
+		
+		//How many chunks a source may fall behind the newest before it reads
+		//on alone, for parses started from now on. 
+		void setmaxlag(unsigned int chunks) {
+			lock_guard<mutex> guard(lock); 
+			maxlag = chunks; 
+		}
+		
+		//Called by a source that has gone back to reading the file itself. 
+		void detach() {
+			lock_guard<mutex> guard(lock); 
+			detached++; 
+		}
+		
+		//A SharedParse of the file and where to start in it, or nothing if 
+		//the registry is off or the file can't be found. 
+		template<class T>
+		shared_ptr<SharedParse<T>> attach(const string & filename, unsigned int limit, shared_ptr<ParseChunk<T>> & start, unsigned long & cursor) {
+			
+			lock_guard<mutex> guard(lock); 
+			
+			if(!enabled) return shared_ptr<SharedParse<T>>(); 
+			
+			string k = key<T>(filename, limit); 
+			if(k.empty()) return shared_ptr<SharedParse<T>>(); 
+			
+			for(auto it = producers.begin(); it != producers.end(); ) {
+				if(it->second.expired()) it = producers.erase(it); 
+				else ++it; 
+			}
+			
+			auto it = producers.find(k); 
+			if(it != producers.end()) {
+				auto existing = std::static_pointer_cast<SharedParse<T>>(it->second.lock()); 
+				if(existing) {
+					start = existing->start(cursor); 
+					if(start) {
+						shared++; 
+						return existing; 
+					}
+				}
+			}
+			
+			shared_ptr<SharedParse<T>> created(new SharedParse<T>(filename, limit, maxlag)); 
+			producers[k] = std::static_pointer_cast<void>(created); 
+			start = created->start(cursor); 
+			
+			return created; 
+			
+		}
+		
+		//how many sources have joined a parse that was already there 
+		unsigned long getshared() {
+			lock_guard<mutex> guard(lock); 
+			return shared; 
+		}
+		
+		//how many sources have fallen behind and gone back to the file 
+		unsigned long getdetached() {
+			lock_guard<mutex> guard(lock); 
+			return detached; 
+		}
+		
+		//how many files have a parse in use (the latest for each, if there are several) 
+		size_t getparses() {
+			lock_guard<mutex> guard(lock); 
+			size_t n = 0; 
+			for(auto & p : producers) if(!p.second.expired()) n++; 
+			return n; 
+		}
+		
+};
+
+}
+
+#endif
@@ -35,47 +35,14 @@ all the data.
 #ifndef SharedSource_HEADER
 #define SharedSource_HEADER
 
-#include <vector>
-
-#include "DataSource.hpp"
-
-using std::vector; 
+#include "WindowedSource.hpp"
 
 namespace libsim 
 {
 
-template<class T>
-class SharedSource : public DataSource<T> {
-	
-	private:
-		T * data;
-		const unsigned int size; 
-		unsigned int start; 
-
-	public:
-		SharedSource(T * _data, unsigned int _size, unsigned int _windowsize) : DataSource<T>(_windowsize), data(_data), size(_size), start(0) {}
-		
-		SharedSource(SharedSource<T> const & cpy) = delete; 
-		SharedSource<T>& operator =(const SharedSource<T>& cpy) = delete; 
-	
-		//Moving is fine, so support rvalue move and move assignment operators.
-		SharedSource(SharedSource<T> && mv) : DataSource<T>(mv.windowsize), data(mv.data), size(mv.size), start(mv.start) {}
-		SharedSource<T>& operator =(SharedSource<T> && mv) { data = mv.data; size = mv.size; start = mv.start; return *this; }
-		~SharedSource() = default; 
-    
-		//get a pointer to the start of the window
-		T * get()  {
-			return data + start;
-		}
-		
-		//increment the start pointer
-		void tick() { start++; }
-		
-		//check that the window is still valid
-		bool eods() { return start > (size - this->windowsize); }
-		
-};
+template<class T, unsigned int N = 0>
+using SharedSource = WindowedSource<T, BorrowedStorage<T>, N>; 
 
 }
 
-#endif
\ No newline at end of file
+#endif
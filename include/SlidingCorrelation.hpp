@@ -0,0 +1,319 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+Pearson correlation and covariance between two sources over a sliding window, 
+at a set of lags, kept up to date instead of recomputed for every window. 
+
+At lag l the window pairs a[t + i] with b[t + i + l] for i from 0 to W - 1 
+(lags may be negative). For each lag the sums of a, a^2, b, b^2 and ab over 
+the window are kept, and each tick only takes off the pair that leaves and 
+adds the one that arrives, so a tick is O(1) per lag whatever W is. The 
+values are shifted by the first values seen before they are summed, to keep 
+the subtraction in the variance well conditioned, and every reanchor ticks the
+sums are recomputed from the data to stop rounding error accumulating. 
+
+Each source is read as a stream of elements through its own buffer, so the 
+two can have any windowsize and prefetch at their own rates; the buffers hold
+about a window plus the largest lag. The sources are borrowed and must 
+outlive the SlidingCorrelation; tick this, not them. 
+
+Covariances are sample covariances (divided by W - 1), as gsl_stats_covariance.
+
+*/
+
+#ifndef SlidingCorrelation_HEADER
+#define SlidingCorrelation_HEADER
+
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <exception>
+
+#include "DataSource.hpp"
+#include "SampleStream.hpp"
+
+using std::vector;
+using std::exception; 
+
+namespace libsim 
+{
+
+class SlidingCorrelationInvalidException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "no window, or the windowsize is less than 2, or there are no lags";
+	}
+	
+};
+
+template<class T>
+class SlidingCorrelation {
+	
+	private:
+		//One source, read as elements into a buffer indexed from the start 
+		//of the stream. 
+		class Buffer {
+			
+			private:
+				SampleStream<T> stream; 
+				vector<T> data; 
+				unsigned long base; 
+				unsigned int chunk; 
+			
+			public:
+				Buffer(DataSource<T> & source, unsigned int _chunk) : stream(source), data(), base(0), chunk(_chunk) {}
+				
+				//Make sure element i has been read, if it exists. 
+				inline bool ensure(unsigned long i) {
+					
+					while(base + data.size() <= i) {
+						size_t from = data.size(); 
+						data.resize(from + chunk); 
+						size_t read = stream.read(data.data() + from, chunk); 
+						data.resize(from + read); 
+						if(read == 0) return false; 
+					}
+					
+					return true; 
+					
+				}
+				
+				inline double at(unsigned long i) const { return (double) data[i - base]; }
+				inline size_t held() const { return data.size(); }
+				
+				//Drop everything before element i, once there is enough of it
+				//to be worth moving the rest. 
+				inline void discard(unsigned long i) {
+					if(i <= base || i - base < chunk) return; 
+					data.erase(data.begin(), data.begin() + (i - base)); 
+					base = i; 
+				}
+				
+		};
+		
+		Buffer a; 
+		Buffer b; 
+		
+		const unsigned int windowsize; 
+		vector<int> lags; 
+		
+		//Window p uses a from p + shift and b from p + shift + lag, so that
+		//negative lags never index before the start of a. 
+		unsigned long shift; 
+		unsigned long position; 
+		int minlag; 
+		int maxlag; 
+		
+		//Sums over the window, of the values less ka or kb. 
+		double ka, kb; 
+		double sa, saa; 
+		vector<double> sb, sbb, sab; 
+		
+		vector<double> results; 
+		
+		unsigned int reanchor; 
+		unsigned int updates; 
+		bool anchored; 
+		bool finished; 
+		
+		inline unsigned long firsta() const { return position + shift; }
+		inline unsigned long firstb(unsigned int k) const { return position + shift + lags[k]; }
+		
+		//Drop what is behind the current window from both buffers. 
+		inline void release() {
+			a.discard(firsta()); 
+			b.discard(position + shift + minlag); 
+		}
+		
+		//Is all the data for window p there? 
+		inline bool available(unsigned long p) {
+			if(finished) return false; 
+			release(); 
+			if(!a.ensure(p + shift + windowsize - 1) || !b.ensure(p + shift + maxlag + windowsize - 1)) finished = true; 
+			return !finished; 
+		}
+		
+		inline void anchor() {
+			
+			if(!available(position)) throw SlidingCorrelationInvalidException(); 
+			
+			ka = a.at(firsta()); 
+			kb = b.at(firstb(0)); 
+			
+			sa = saa = 0.0; 
+			for(unsigned int i = 0; i < windowsize; i++) {
+				double x = a.at(firsta() + i) - ka; 
+				sa += x; 
+				saa += x * x; 
+			}
+			
+			for(unsigned int k = 0; k < lags.size(); k++) {
+				sb[k] = sbb[k] = sab[k] = 0.0; 
+				for(unsigned int i = 0; i < windowsize; i++) {
+					double x = a.at(firsta() + i) - ka; 
+					double y = b.at(firstb(k) + i) - kb; 
+					sb[k] += y; 
+					sbb[k] += y * y; 
+					sab[k] += x * y; 
+				}
+			}
+			
+			updates = 0; 
+			anchored = true; 
+			
+		}
+		
+		inline double cov(unsigned int k) const {
+			return (sab[k] - sa * sb[k] / windowsize) / (windowsize - 1); 
+		}
+		
+	public:
+		SlidingCorrelation(DataSource<T> & _a, DataSource<T> & _b, unsigned int _windowsize, vector<int> _lags = vector<int>(1, 0), unsigned int _reanchor = 0) : 
+			a(_a, std::max(_windowsize, 1024u)), 
+			b(_b, std::max(_windowsize, 1024u)), 
+			windowsize(_windowsize), 
+			lags(_lags), 
+			shift(0), 
+			position(0), 
+			minlag(0), 
+			maxlag(0), 
+			ka(0.0), 
+			kb(0.0), 
+			sa(0.0), 
+			saa(0.0), 
+			sb(_lags.size(), 0.0), 
+			sbb(_lags.size(), 0.0), 
+			sab(_lags.size(), 0.0), 
+			results(_lags.size(), 0.0), 
+			reanchor(_reanchor), 
+			updates(0), 
+			anchored(false), 
+			finished(false) 
+		{
+			
+			if(windowsize < 2 || lags.empty()) throw SlidingCorrelationInvalidException(); 
+			
+			minlag = *std::min_element(lags.begin(), lags.end()); 
+			maxlag = *std::max_element(lags.begin(), lags.end()); 
+			
+			shift = (minlag < 0) ? -minlag : 0; 
+			maxlag = std::max(maxlag, 0); 
+			
+			if(reanchor == 0) reanchor = std::max(windowsize, 1024u); 
+			
+		}
+		
+		SlidingCorrelation(SlidingCorrelation<T> const & cpy) = delete; 
+		SlidingCorrelation<T>& operator =(const SlidingCorrelation<T>& cpy) = delete; 
+		
+		SlidingCorrelation(SlidingCorrelation<T> && mv) = default; 
+		SlidingCorrelation<T>& operator =(SlidingCorrelation<T> && mv) = delete; 
+		~SlidingCorrelation() = default; 
+		
+		//at the k-th lag; NaN if either side is constant over the window 
+		double correlation(unsigned int k = 0) {
+			
+			if(!anchored) anchor(); 
+			
+			double va = saa - sa * sa / windowsize; 
+			double vb = sbb[k] - sb[k] * sb[k] / windowsize; 
+			
+			if(va <= 0.0 || vb <= 0.0) return std::numeric_limits<double>::quiet_NaN(); 
+			
+			return std::max(-1.0, std::min(1.0, (sab[k] - sa * sb[k] / windowsize) / std::sqrt(va * vb))); 
+			
+		}
+		
+		double covariance(unsigned int k = 0) {
+			if(!anchored) anchor(); 
+			return cov(k); 
+		}
+		
+		//Every lag at once, in the order of getlags(). 
+		const double * correlations() {
+			for(unsigned int k = 0; k < lags.size(); k++) results[k] = correlation(k); 
+			return results.data(); 
+		}
+		
+		const double * covariances() {
+			for(unsigned int k = 0; k < lags.size(); k++) results[k] = covariance(k); 
+			return results.data(); 
+		}
+		
+		inline const vector<int> & getlags() const { return lags; }
+		inline unsigned int getwindowsize() const { return windowsize; }
+		
+		//the elements held from the two sources 
+		inline size_t getbuffered() const { return a.held() + b.held(); }
+		
+		void tick() {
+			
+			if(!anchored) {
+				position++; 
+				release(); 
+				return; 
+			}
+			
+			if(!available(position + 1)) {
+				position++; 
+				release(); 
+				anchored = false; 
+				return; 
+			}
+			
+			double xo = a.at(firsta()) - ka; 
+			double xn = a.at(firsta() + windowsize) - ka; 
+			
+			for(unsigned int k = 0; k < lags.size(); k++) {
+				double yo = b.at(firstb(k)) - kb; 
+				double yn = b.at(firstb(k) + windowsize) - kb; 
+				sb[k] += yn - yo; 
+				sbb[k] += yn * yn - yo * yo; 
+				sab[k] += xn * yn - xo * yo; 
+			}
+			
+			sa += xn - xo; 
+			saa += xn * xn - xo * xo; 
+			
+			position++; 
+			
+			release(); 
+			
+			if(++updates >= reanchor) anchored = false; 
+			
+		}
+		
+		bool eods() { return !available(position); }
+		
+};
+
+}
+
+#endif
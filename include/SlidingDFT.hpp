@@ -0,0 +1,292 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+Keeps the DFT of a source's window up to date as the window moves, instead of
+transforming every window from scratch. When the window moves on by one 
+element, each bin is updated from the element that left and the one that 
+arrived: 
+
+	X'[k] = (X[k] - x_old + x_new) * exp(2 pi i k / W)
+
+which is O(1) per bin, so O(W) per tick for the whole spectrum or O(bins) 
+when only a few bins are tracked. The spectrum uses the same convention as 
+GSL and FFTW, X[k] = sum of x[n] exp(-2 pi i k n / W), unnormalised. 
+
+The rounding errors of the updates accumulate, so every reanchor updates the 
+spectrum is recomputed from the window itself: with an FFT for the whole 
+spectrum when W is a power of two (a plain DFT otherwise), and with Goertzel's
+recurrence, O(W) per bin, when only some bins are tracked. The same happens 
+when tick() is asked to skip so far that sliding would cost more than 
+recomputing. 
+
+The source is borrowed and must outlive the SlidingDFT; tick the SlidingDFT, 
+not the source. 
+
+*/
+
+#ifndef SlidingDFT_HEADER
+#define SlidingDFT_HEADER
+
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <algorithm>
+#include <exception>
+
+#include "DataSource.hpp"
+
+using std::vector;
+using std::complex;
+using std::exception; 
+
+namespace libsim 
+{
+
+class SlidingDFTInvalidException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "bin out of range, or no window to transform";
+	}
+	
+};
+
+template<class T>
+class SlidingDFT {
+	
+	private:
+		DataSource<T> * source; 
+		const unsigned int windowsize; 
+		
+		//Which bins, and where each one rotates to per element. 
+		vector<unsigned int> bins; 
+		vector<complex<double>> rotation; 
+		vector<complex<double>> X; 
+		bool full; 
+		
+		unsigned int reanchor; 
+		unsigned int updates; 
+		bool anchored; 
+		
+		vector<double> deltas; 
+		
+		static inline double pi() { return 3.14159265358979323846; }
+		
+		static inline double angle(unsigned int k, unsigned int w) {
+			return 2.0 * pi() * (double) k / (double) w; 
+		}
+		
+		static inline bool poweroftwo(unsigned int n) { return n && !(n & (n - 1)); }
+		
+		//In place, radix 2, for power of two sizes. 
+		static void fft(vector<complex<double>> & a) {
+			
+			const size_t n = a.size(); 
+			
+			for(size_t i = 1, j = 0; i < n; i++) {
+				size_t bit = n >> 1; 
+				for(; j & bit; bit >>= 1) j ^= bit; 
+				j ^= bit; 
+				if(i < j) std::swap(a[i], a[j]); 
+			}
+			
+			for(size_t len = 2; len <= n; len <<= 1) {
+				complex<double> wlen = std::polar(1.0, -2.0 * pi() / (double) len); 
+				for(size_t i = 0; i < n; i += len) {
+					complex<double> w(1.0, 0.0); 
+					for(size_t j = 0; j < len / 2; j++) {
+						complex<double> u = a[i + j], v = a[i + j + len / 2] * w; 
+						a[i + j] = u + v; 
+						a[i + j + len / 2] = u - v; 
+						w *= wlen; 
+					}
+				}
+			}
+			
+		}
+		
+		//One bin of the window, by Goertzel's recurrence. 
+		inline complex<double> goertzel(const T * x, unsigned int k) const {
+			
+			double w = angle(k, windowsize); 
+			double coeff = 2.0 * std::cos(w); 
+			double s1 = 0.0, s2 = 0.0; 
+			
+			for(unsigned int n = 0; n < windowsize; n++) {
+				double s = (double) x[n] + coeff * s1 - s2; 
+				s2 = s1; 
+				s1 = s; 
+			}
+			
+			//y = s1 - exp(-iw) s2 is the DFT rotated by exp(iw(W-1)) 
+			complex<double> y = complex<double>(s1, 0.0) - std::polar(1.0, -w) * s2; 
+			return y * std::polar(1.0, -w * (double) (windowsize - 1)); 
+			
+		}
+		
+		//Recompute the spectrum from the window. 
+		inline void anchor() {
+			
+			if(source->eods()) throw SlidingDFTInvalidException(); 
+			
+			const T * x = source->get(); 
+			
+			if(full && poweroftwo(windowsize)) {
+				
+				for(unsigned int n = 0; n < windowsize; n++) X[n] = complex<double>((double) x[n], 0.0); 
+				fft(X); 
+				
+			}
+			else {
+				
+				for(size_t b = 0; b < bins.size(); b++) X[b] = goertzel(x, bins[b]); 
+				
+			}
+			
+			updates = 0; 
+			anchored = true; 
+			
+		}
+		
+		//What recomputing costs, in bin updates. 
+		inline double anchorcost() const {
+			if(full && poweroftwo(windowsize)) return windowsize * std::log2((double) windowsize); 
+			return (double) windowsize * bins.size(); 
+		}
+		
+		inline void setup() {
+			
+			rotation.reserve(bins.size()); 
+			
+			for(auto k : bins) {
+				if(k >= windowsize) throw SlidingDFTInvalidException(); 
+				rotation.push_back(std::polar(1.0, angle(k, windowsize))); 
+			}
+			
+			X.resize(bins.size()); 
+			
+			if(reanchor == 0) reanchor = std::max(windowsize, 1024u); 
+			
+		}
+		
+	public:
+		//Every bin. 
+		SlidingDFT(DataSource<T> & _source, unsigned int _reanchor = 0) : 
+			source(&_source), 
+			windowsize(_source.getwindowsize()), 
+			bins(), 
+			rotation(), 
+			X(), 
+			full(true), 
+			reanchor(_reanchor), 
+			updates(0), 
+			anchored(false), 
+			deltas() 
+		{
+			for(unsigned int k = 0; k < windowsize; k++) bins.push_back(k); 
+			setup(); 
+		}
+		
+		//Only the given bins, in the given order. 
+		SlidingDFT(DataSource<T> & _source, vector<unsigned int> _bins, unsigned int _reanchor = 0) : 
+			source(&_source), 
+			windowsize(_source.getwindowsize()), 
+			bins(_bins), 
+			rotation(), 
+			X(), 
+			full(false), 
+			reanchor(_reanchor), 
+			updates(0), 
+			anchored(false), 
+			deltas() 
+		{
+			setup(); 
+		}
+		
+		SlidingDFT(SlidingDFT<T> const & cpy) = delete; 
+		SlidingDFT<T>& operator =(const SlidingDFT<T>& cpy) = delete; 
+		
+		SlidingDFT(SlidingDFT<T> && mv) = default; 
+		SlidingDFT<T>& operator =(SlidingDFT<T> && mv) = delete; 
+		~SlidingDFT() = default; 
+		
+		//the spectrum of the current window, one value per tracked bin 
+		const complex<double> * spectrum() {
+			if(!anchored) anchor(); 
+			return X.data(); 
+		}
+		
+		inline const vector<unsigned int> & getbins() const { return bins; }
+		inline unsigned int getwindowsize() const { return windowsize; }
+		
+		//Move the window on by stride elements. 
+		void tick(unsigned int stride = 1) {
+			
+			if(stride == 0) return; 
+			
+			//Sliding this far would cost more than starting again. 
+			if(!anchored || stride >= windowsize || stride * (double) bins.size() > anchorcost()) {
+				for(unsigned int i = 0; i < stride; i++) source->tick(); 
+				anchored = false; 
+				return; 
+			}
+			
+			//The elements that leave are at the front of the window now, and 
+			//the ones that arrive will be at the back of it afterwards. 
+			const T * x = source->get(); 
+			deltas.resize(stride); 
+			for(unsigned int i = 0; i < stride; i++) deltas[i] = -(double) x[i]; 
+			
+			for(unsigned int i = 0; i < stride; i++) source->tick(); 
+			
+			if(source->eods()) {
+				anchored = false; 
+				return; 
+			}
+			
+			const T * news = source->get() + (windowsize - stride); 
+			for(unsigned int i = 0; i < stride; i++) deltas[i] += (double) news[i]; 
+			
+			for(size_t b = 0; b < X.size(); b++) {
+				complex<double> v = X[b]; 
+				for(unsigned int i = 0; i < stride; i++) v = (v + deltas[i]) * rotation[b]; 
+				X[b] = v; 
+			}
+			
+			updates += stride; 
+			if(updates >= reanchor) anchored = false; 
+			
+		}
+		
+		bool eods() { return source->eods(); }
+		
+};
+
+}
+
+#endif
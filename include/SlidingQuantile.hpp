@@ -0,0 +1,168 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+Medians, quantiles and other order statistics of a source's window, kept up 
+to date as the window moves instead of sorting a copy of every window. The 
+window's elements are held in an IndexableSkiplist; each tick removes the 
+element that leaves and inserts the one that arrives, O(log W) each, and each 
+quantile is a lookup by rank, also O(log W). 
+
+Quantiles are interpolated the same way as gsl_stats_quantile_from_sorted_data:
+the quantile q is at rank q * (W - 1), between the elements either side. 
+
+The source is borrowed and must outlive the SlidingQuantile; tick the 
+SlidingQuantile, not the source. 
+
+*/
+
+#ifndef SlidingQuantile_HEADER
+#define SlidingQuantile_HEADER
+
+#include <vector>
+#include <cmath>
+#include <exception>
+
+#include "DataSource.hpp"
+#include "IndexableSkiplist.hpp"
+
+using std::vector;
+using std::exception; 
+
+namespace libsim 
+{
+
+class SlidingQuantileInvalidException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "quantile outside [0, 1], or no window";
+	}
+	
+};
+
+template<class T>
+class SlidingQuantile {
+	
+	private:
+		DataSource<T> * source; 
+		const unsigned int windowsize; 
+		IndexableSkiplist<T> window; 
+		bool loaded; 
+		
+		inline void load() {
+			
+			if(source->eods()) throw SlidingQuantileInvalidException(); 
+			
+			const T * x = source->get(); 
+			window.clear(); 
+			for(unsigned int n = 0; n < windowsize; n++) window.insert(x[n]); 
+			
+			loaded = true; 
+			
+		}
+		
+	public:
+		SlidingQuantile(DataSource<T> & _source) : 
+			source(&_source), 
+			windowsize(_source.getwindowsize()), 
+			window(_source.getwindowsize()), 
+			loaded(false) 
+		{}
+		
+		SlidingQuantile(SlidingQuantile<T> const & cpy) = delete; 
+		SlidingQuantile<T>& operator =(const SlidingQuantile<T>& cpy) = delete; 
+		
+		SlidingQuantile(SlidingQuantile<T> && mv) = default; 
+		SlidingQuantile<T>& operator =(SlidingQuantile<T> && mv) = delete; 
+		~SlidingQuantile() = default; 
+		
+		//the element of rank i in the window, 0 being the smallest 
+		T at(unsigned int i) {
+			if(!loaded) load(); 
+			return window.at(i); 
+		}
+		
+		double quantile(double q) {
+			
+			if(!(q >= 0.0 && q <= 1.0)) throw SlidingQuantileInvalidException(); 
+			if(!loaded) load(); 
+			
+			double rank = q * (windowsize - 1); 
+			unsigned int lo = (unsigned int) std::floor(rank); 
+			double frac = rank - lo; 
+			
+			double value = (double) window.at(lo); 
+			if(frac > 0.0) value += frac * ((double) window.at(lo + 1) - value); 
+			
+			return value; 
+			
+		}
+		
+		inline double median() { return quantile(0.5); }
+		
+		//Several quantiles of the same window at once. 
+		vector<double> quantiles(const vector<double> & qs) {
+			
+			vector<double> results; 
+			results.reserve(qs.size()); 
+			
+			for(auto q : qs) results.push_back(quantile(q)); 
+			
+			return results; 
+			
+		}
+		
+		inline unsigned int getwindowsize() const { return windowsize; }
+		
+		void tick() {
+			
+			if(!loaded) {
+				source->tick(); 
+				return; 
+			}
+			
+			T old = source->get()[0]; 
+			source->tick(); 
+			
+			if(source->eods()) {
+				loaded = false; 
+				return; 
+			}
+			
+			window.remove(old); 
+			window.insert(source->get()[windowsize - 1]); 
+			
+		}
+		
+		bool eods() { return source->eods(); }
+		
+};
+
+}
+
+#endif
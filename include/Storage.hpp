@@ -0,0 +1,116 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* 
+Storage policies for WindowedSource. Each one holds a contiguous run of T and 
+provides data() and size(); they differ only in who owns the memory and whether
+it can grow. None of them copy anything they don't have to: OwnedStorage moves 
+the vector it is given, BorrowedStorage only points at memory that belongs to 
+somebody else. 
+*/
+
+#ifndef Storage_HEADER
+#define Storage_HEADER
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <cstddef>
+
+using std::vector;
+using std::allocator;
+using std::move; 
+using std::size_t; 
+
+namespace libsim 
+{
+
+//Owns a vector. Pass an rvalue and nothing is copied; an lvalue is copied once.
+//Alloc can be a PageAllocator, for huge pages or NUMA placement. 
+template<class T, class Alloc = allocator<T>>
+class OwnedStorage {
+	
+	protected:
+		vector<T, Alloc> values; 
+	
+	public:
+		OwnedStorage(vector<T, Alloc> _values) : values(move(_values)) {}
+		
+		OwnedStorage(OwnedStorage<T, Alloc> const & cpy) = delete; 
+		OwnedStorage<T, Alloc>& operator =(const OwnedStorage<T, Alloc>& cpy) = delete; 
+		
+		OwnedStorage(OwnedStorage<T, Alloc> && mv) = default; 
+		OwnedStorage<T, Alloc>& operator =(OwnedStorage<T, Alloc> && mv) = default; 
+		~OwnedStorage() = default; 
+		
+		inline T * data() { return values.data(); }
+		inline size_t size() const { return values.size(); }
+		
+};
+
+//An OwnedStorage that can be added to. 
+template<class T, class Alloc = allocator<T>>
+class AppendableStorage : public OwnedStorage<T, Alloc> {
+	
+	public:
+		AppendableStorage(vector<T, Alloc> _values) : OwnedStorage<T, Alloc>(move(_values)) {}
+		
+		AppendableStorage(AppendableStorage<T, Alloc> const & cpy) = delete; 
+		AppendableStorage<T, Alloc>& operator =(const AppendableStorage<T, Alloc>& cpy) = delete; 
+		
+		AppendableStorage(AppendableStorage<T, Alloc> && mv) = default; 
+		AppendableStorage<T, Alloc>& operator =(AppendableStorage<T, Alloc> && mv) = default; 
+		~AppendableStorage() = default; 
+		
+		inline void push_back(T value) { this->values.push_back(value); }
+		
+};
+
+//Points at memory owned elsewhere, which must outlive the source. This will 
+//NOT delete the pointer. 
+template<class T>
+class BorrowedStorage {
+	
+	private:
+		T * values; 
+		size_t count; 
+	
+	public:
+		BorrowedStorage(T * _values, size_t _count) : values(_values), count(_count) {}
+		
+		BorrowedStorage(BorrowedStorage<T> const & cpy) = default; 
+		BorrowedStorage<T>& operator =(const BorrowedStorage<T>& cpy) = default; 
+		~BorrowedStorage() = default; 
+		
+		inline T * data() { return values; }
+		inline size_t size() const { return count; }
+		
+};
+
+}
+
+#endif
@@ -0,0 +1,320 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+Windows defined by time rather than by a count of elements: "the last span 
+seconds". The data is (timestamp, value) pairs, with timestamps in seconds (or
+any unit, as long as span and step use the same one) that never go backwards. 
+
+Each window is every sample with end - span < t <= end. With a step of 0 the 
+end moves to the next sample on every tick(), so there is a window ending at 
+every sample; with a step > 0 it moves by step, on a regular grid starting at 
+the first timestamp, and windows over a gap in the data may be empty. 
+
+The window is two indices into a buffer of timestamps and a buffer of values,
+held separately, so get() and times() are contiguous arrays of size() 
+elements. Both indices only ever move forward, so a tick() costs O(1) 
+amortised however many samples enter or leave the window. Samples are read in 
+chunks by a TimedLoader (TimedFileLoader for text, TimedSQLiteLoader in 
+SQLiteLoaders.hpp), and the next chunk is read in the background while the 
+current one is in use. 
+
+Because the window has no fixed size, this isn't a DataSource. 
+
+*/
+
+#ifndef TimeWindowSource_HEADER
+#define TimeWindowSource_HEADER
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <future>
+#include <utility>
+#include <algorithm>
+#include <exception>
+
+using std::string;
+using std::vector;
+using std::ifstream;
+using std::stringstream; 
+using std::unique_ptr;
+using std::future;
+using std::async;
+using std::launch;
+using std::move;
+using std::exception; 
+
+namespace libsim 
+{
+
+class TimeWindowSourceInvalidException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "no window available, or the timestamps go backwards";
+	}
+	
+};
+
+template<class T>
+class TimedLoader {
+	
+	public:
+		virtual ~TimedLoader() {}
+		
+		//Append up to count samples to times and values, and return how many; 
+		//fewer only at the end of the data. 
+		virtual size_t load(vector<double> & times, vector<T> & values, size_t count) = 0; 
+		
+};
+
+//One sample per line: a timestamp and a value, separated by whitespace or a 
+//comma. Blank lines are skipped. 
+template<class T>
+class TimedFileLoader : public TimedLoader<T> {
+	
+	private:
+		ifstream file; 
+	
+	public:
+		TimedFileLoader(string filename) : file(filename) {}
+		
+		TimedFileLoader(TimedFileLoader<T> const & cpy) = delete; 
+		TimedFileLoader<T>& operator =(const TimedFileLoader<T>& cpy) = delete; 
+		
+		virtual size_t load(vector<double> & times, vector<T> & values, size_t count) override {
+			
+			size_t n = 0; 
+			string stemp; 
+			
+			while(n < count && getline(file, stemp)) {
+				
+				std::replace(stemp.begin(), stemp.end(), ',', ' '); 
+				
+				stringstream ss(stemp); 
+				double t; 
+				T v; 
+				if(!(ss >> t >> v)) continue; 
+				
+				times.push_back(t); 
+				values.push_back(v); 
+				n++; 
+				
+			}
+			
+			return n; 
+			
+		}
+		
+};
+
+template<class T>
+class TimeWindowSource {
+	
+	private:
+		struct Chunk {
+			vector<double> times; 
+			vector<T> values; 
+		};
+	
+		unique_ptr<TimedLoader<T>> loader; 
+		double span; 
+		double step; 
+		size_t chunk; 
+		
+		vector<double> timestamps; 
+		vector<T> values; 
+		
+		//The window is [first, last) of the buffers, and ends at time end. 
+		size_t first; 
+		size_t last; 
+		double end; 
+		
+		future<Chunk> next; 
+		bool exhausted; 
+		bool done; 
+		
+		inline void prefetch() {
+			
+			TimedLoader<T> * l = loader.get(); 
+			size_t n = chunk; 
+			
+			next = async(launch::async, [l, n]() {
+				Chunk c; 
+				c.times.reserve(n); 
+				c.values.reserve(n); 
+				l->load(c.times, c.values, n); 
+				return c; 
+			});
+			
+		}
+		
+		//Take the prefetched chunk, and start on the one after. False if 
+		//there was nothing left. 
+		inline bool more() {
+			
+			if(exhausted) return false; 
+			
+			Chunk c = next.get(); 
+			
+			if(c.times.size() < chunk) exhausted = true; 
+			else prefetch(); 
+			
+			if(c.times.empty()) return false; 
+			
+			double previous = timestamps.empty() ? c.times.front() : timestamps.back(); 
+			if(!std::is_sorted(c.times.begin(), c.times.end()) || c.times.front() < previous) {
+				throw TimeWindowSourceInvalidException(); 
+			}
+			
+			//Drop whatever the window has left behind before growing. 
+			if(first > 0) {
+				timestamps.erase(timestamps.begin(), timestamps.begin() + first); 
+				values.erase(values.begin(), values.begin() + first); 
+				last -= first; 
+				first = 0; 
+			}
+			
+			timestamps.insert(timestamps.end(), c.times.begin(), c.times.end()); 
+			values.insert(values.end(), c.values.begin(), c.values.end()); 
+			
+			return true; 
+			
+		}
+		
+		//Move the window to end at time e. 
+		inline void advance(double e) {
+			
+			end = e; 
+			
+			while(true) {
+				while(last < timestamps.size() && timestamps[last] <= end) last++; 
+				if(last < timestamps.size() || !more()) break; 
+			}
+			
+			while(first < last && timestamps[first] <= end - span) first++; 
+			
+			//Everything has left the window, and nothing more will come. 
+			if(first == timestamps.size() && exhausted) done = true; 
+			
+		}
+		
+		inline void setup() {
+			
+			if(span <= 0.0 || step < 0.0) throw TimeWindowSourceInvalidException(); 
+			
+			prefetch(); 
+			
+			if(!more()) {
+				done = true; 
+				return; 
+			}
+			
+			advance(timestamps.front()); 
+			
+		}
+		
+	public:
+		TimeWindowSource(unique_ptr<TimedLoader<T>> _loader, double _span, double _step = 0.0, size_t _chunk = 4096) : 
+			loader(move(_loader)), 
+			span(_span), 
+			step(_step), 
+			chunk(std::max<size_t>(_chunk, 1)), 
+			timestamps(), 
+			values(), 
+			first(0), 
+			last(0), 
+			end(0.0), 
+			next(), 
+			exhausted(false), 
+			done(false) 
+		{
+			setup(); 
+		}
+		
+		TimeWindowSource(string filename, double _span, double _step = 0.0) : 
+			TimeWindowSource(unique_ptr<TimedLoader<T>>(new TimedFileLoader<T>(filename)), _span, _step) {}
+		
+		TimeWindowSource(TimeWindowSource<T> const & cpy) = delete; 
+		TimeWindowSource<T>& operator =(const TimeWindowSource<T>& cpy) = delete; 
+		
+		//Moving is fine: the prefetch only holds the loader, which stays put.
+		//Assigning would free our loader while our prefetch may be using it. 
+		TimeWindowSource(TimeWindowSource<T> && mv) = default; 
+		TimeWindowSource<T>& operator =(TimeWindowSource<T> && mv) = delete; 
+		
+		~TimeWindowSource() {
+			if(next.valid()) next.wait(); 
+		}
+		
+		//the values in the window, and their timestamps
+		T * get() { 
+			if(done) throw TimeWindowSourceInvalidException(); 
+			return values.data() + first; 
+		}
+		
+		const double * times() { 
+			if(done) throw TimeWindowSourceInvalidException(); 
+			return timestamps.data() + first; 
+		}
+		
+		//the number of samples in the window, which may be 0 
+		inline size_t size() const { return last - first; }
+		
+		//the time the window ends at 
+		inline double getend() const { return end; }
+		inline double getspan() const { return span; }
+		
+		void tick() {
+			
+			if(done) return; 
+			
+			if(step > 0.0) {
+				advance(end + step); 
+				return; 
+			}
+			
+			//Move to the next sample; if there isn't one, we're done. 
+			if(last == timestamps.size() && !more()) {
+				done = true; 
+				return; 
+			}
+			
+			advance(timestamps[last]); 
+			
+		}
+		
+		bool eods() { return done; }
+		
+};
+
+}
+
+#endif
@@ -0,0 +1,152 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+Reads one timestamped input a sample at a time, for sources that interleave 
+several of them (MergeSource). Samples come from a TimedLoader a chunk at a 
+time, and the next chunk is always being read in the background, so each 
+input is prefetched independently of the others. 
+
+*/
+
+#ifndef TimedStream_HEADER
+#define TimedStream_HEADER
+
+#include <vector>
+#include <memory>
+#include <future>
+#include <utility>
+#include <algorithm>
+
+#include "TimeWindowSource.hpp"
+
+using std::vector;
+using std::unique_ptr;
+using std::future;
+using std::async;
+using std::launch;
+using std::move;
+
+namespace libsim 
+{
+
+template<class T>
+class TimedStream {
+	
+	private:
+		struct Chunk {
+			vector<double> times; 
+			vector<T> values; 
+		};
+		
+		unique_ptr<TimedLoader<T>> loader; 
+		size_t chunk; 
+		
+		Chunk current; 
+		size_t position; 
+		
+		future<Chunk> next; 
+		bool exhausted; 
+		
+		inline void prefetch() {
+			
+			TimedLoader<T> * l = loader.get(); 
+			size_t n = chunk; 
+			
+			next = async(launch::async, [l, n]() {
+				Chunk c; 
+				c.times.reserve(n); 
+				c.values.reserve(n); 
+				l->load(c.times, c.values, n); 
+				return c; 
+			});
+			
+		}
+		
+		//Move on to the prefetched chunk, if the current one is used up. 
+		inline bool ready() {
+			
+			while(position == current.times.size()) {
+				
+				if(exhausted) return false; 
+				
+				double previous = current.times.empty() ? 0.0 : current.times.back(); 
+				bool started = !current.times.empty(); 
+				
+				current = next.get(); 
+				position = 0; 
+				
+				if(current.times.size() < chunk) exhausted = true; 
+				else prefetch(); 
+				
+				if(!std::is_sorted(current.times.begin(), current.times.end())) throw TimeWindowSourceInvalidException(); 
+				if(started && !current.times.empty() && current.times.front() < previous) throw TimeWindowSourceInvalidException(); 
+				
+			}
+			
+			return true; 
+			
+		}
+	
+	public:
+		TimedStream(unique_ptr<TimedLoader<T>> _loader, size_t _chunk = 4096) : 
+			loader(move(_loader)), 
+			chunk(std::max<size_t>(_chunk, 1)), 
+			current(), 
+			position(0), 
+			next(), 
+			exhausted(false) 
+		{
+			prefetch(); 
+		}
+		
+		TimedStream(TimedStream<T> const & cpy) = delete; 
+		TimedStream<T>& operator =(const TimedStream<T>& cpy) = delete; 
+		
+		//As with TimeWindowSource, the prefetch holds only the loader. 
+		TimedStream(TimedStream<T> && mv) = default; 
+		TimedStream<T>& operator =(TimedStream<T> && mv) = delete; 
+		
+		~TimedStream() {
+			if(next.valid()) next.wait(); 
+		}
+		
+		//Is there another sample? 
+		inline bool more() { return ready(); }
+		
+		//The next sample; only if more(). 
+		inline double time() const { return current.times[position]; }
+		inline T value() const { return current.values[position]; }
+		
+		inline void pop() { position++; }
+		
+};
+
+}
+
+#endif
@@ -0,0 +1,191 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+Transform stages for TransformSource, composed with |: 
+
+	auto stages = scale(0.001) | where([](double v) { return v == v; }) | clip(-5.0, 5.0); 
+
+Each stage is a small class whose apply() changes an element in place and 
+returns false if the element should be dropped. a | b is a Pipe<A, B> whose 
+apply() is a.apply(v) && b.apply(v), so the whole chain is one type and the 
+compiler sees, and inlines, the lot: a pipeline costs what the equivalent 
+hand-written loop does. 
+
+	apply(f)          v = f(v) (a map)
+	where(p)          keeps v only if p(v) (a filter)
+	scale(k, c)       v = v * k + c
+	clip(lo, hi)      clamps v to [lo, hi]
+	detrend(alpha)    subtracts an exponentially weighted running mean
+
+Stages may keep state (detrend does); each TransformSource has its own copy. 
+
+*/
+
+#ifndef Transform_HEADER
+#define Transform_HEADER
+
+#include <utility>
+
+using std::move; 
+
+namespace libsim 
+{
+
+//Every stage derives from this, which is what lets | find them. 
+template<class Derived>
+class Stage {
+	
+	public:
+		inline Derived & self() { return static_cast<Derived &>(*this); }
+		inline const Derived & self() const { return static_cast<const Derived &>(*this); }
+	
+};
+
+template<class A, class B>
+class Pipe : public Stage<Pipe<A, B>> {
+	
+	private:
+		A first; 
+		B second; 
+	
+	public:
+		Pipe(A _first, B _second) : first(move(_first)), second(move(_second)) {}
+		
+		template<class T>
+		inline bool apply(T & v) { return first.apply(v) && second.apply(v); }
+	
+};
+
+template<class A, class B>
+inline Pipe<A, B> operator |(const Stage<A> & a, const Stage<B> & b) {
+	return Pipe<A, B>(a.self(), b.self()); 
+}
+
+template<class F>
+class ApplyStage : public Stage<ApplyStage<F>> {
+	
+	private:
+		F f; 
+	
+	public:
+		ApplyStage(F _f) : f(move(_f)) {}
+		
+		template<class T>
+		inline bool apply(T & v) { v = f(v); return true; }
+	
+};
+
+template<class P>
+class WhereStage : public Stage<WhereStage<P>> {
+	
+	private:
+		P p; 
+	
+	public:
+		WhereStage(P _p) : p(move(_p)) {}
+		
+		template<class T>
+		inline bool apply(T & v) { return p(v); }
+	
+};
+
+template<class S>
+class ScaleStage : public Stage<ScaleStage<S>> {
+	
+	private:
+		S factor; 
+		S offset; 
+	
+	public:
+		ScaleStage(S _factor, S _offset) : factor(_factor), offset(_offset) {}
+		
+		template<class T>
+		inline bool apply(T & v) { v = v * factor + offset; return true; }
+	
+};
+
+template<class S>
+class ClipStage : public Stage<ClipStage<S>> {
+	
+	private:
+		S lo; 
+		S hi; 
+	
+	public:
+		ClipStage(S _lo, S _hi) : lo(_lo), hi(_hi) {}
+		
+		template<class T>
+		inline bool apply(T & v) { 
+			if(v < lo) v = lo; 
+			else if(v > hi) v = hi; 
+			return true; 
+		}
+	
+};
+
+class DetrendStage : public Stage<DetrendStage> {
+	
+	private:
+		double alpha; 
+		double mean; 
+		bool started; 
+	
+	public:
+		DetrendStage(double _alpha) : alpha(_alpha), mean(0.0), started(false) {}
+		
+		template<class T>
+		inline bool apply(T & v) { 
+			if(!started) {
+				mean = v; 
+				started = true; 
+			}
+			else mean += alpha * (v - mean); 
+			v = v - mean; 
+			return true; 
+		}
+	
+};
+
+template<class F>
+inline ApplyStage<F> apply(F f) { return ApplyStage<F>(move(f)); }
+
+template<class P>
+inline WhereStage<P> where(P p) { return WhereStage<P>(move(p)); }
+
+template<class S>
+inline ScaleStage<S> scale(S factor, S offset = S()) { return ScaleStage<S>(factor, offset); }
+
+template<class S>
+inline ClipStage<S> clip(S lo, S hi) { return ClipStage<S>(lo, hi); }
+
+inline DetrendStage detrend(double alpha) { return DetrendStage(alpha); }
+
+}
+
+#endif
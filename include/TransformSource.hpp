@@ -0,0 +1,197 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+A window over another source with a pipeline of stages (see Transform.hpp) 
+applied to it, without building a transformed copy of the data. Elements are 
+read from the source a chunk at a time, the stages are run over the chunk as 
+it enters the window buffer, and anything the window has passed is dropped, 
+so the buffer holds about one chunk whatever the size of the data. get() is 
+still a contiguous T * for GSL. 
+
+The source is borrowed and must outlive the TransformSource; its windowsize 
+doesn't matter (1 is cheapest). 
+
+*/
+
+#ifndef TransformSource_HEADER
+#define TransformSource_HEADER
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <exception>
+
+#include "DataSource.hpp"
+#include "SampleStream.hpp"
+#include "Transform.hpp"
+
+using std::vector;
+using std::move; 
+using std::exception; 
+
+namespace libsim 
+{
+
+class TransformSourceInvalidException : public exception {
+
+	virtual const char * what()  const noexcept {
+		return "no window available, the source has been exhausted";
+	}
+	
+};
+
+template<class T, class Stages, unsigned int N = 0>
+class TransformSource : public DataSource<T, N> {
+	
+	private:
+		SampleStream<T> samples; 
+		Stages stages; 
+		vector<T> data; 
+		vector<T> raw; 
+		unsigned int start; 
+		unsigned int chunk; 
+		
+		inline bool hasvalidwindow() {
+			return data.size() >= start + this->getwindowsize(); 
+		}
+		
+		//Read and transform the next chunk. 
+		inline void more() {
+			
+			size_t read = samples.read(raw.data(), chunk); 
+			
+			for(size_t i = 0; i < read; i++) {
+				T v = raw[i]; 
+				if(stages.apply(v)) data.push_back(v); 
+			}
+			
+		}
+		
+		//Read and transform chunks until there's a window, or there will 
+		//never be one. 
+		inline bool fill() {
+			
+			if(hasvalidwindow()) return true; 
+			
+			//remove past values (start can be past the end, if we were 
+			//ticked while there was no window) 
+			unsigned int drop = std::min<size_t>(start, data.size()); 
+			data.erase(data.begin(), data.begin() + drop); 
+			start -= drop; 
+			
+			while(!hasvalidwindow() && !samples.finished()) more(); 
+			
+			return hasvalidwindow(); 
+			
+		}
+		
+		inline void setup() {
+			chunk = std::max(4 * this->getwindowsize(), 1024u); 
+			raw.resize(chunk); 
+			data.reserve(chunk + this->getwindowsize()); 
+		}
+
+	public:
+		TransformSource(DataSource<T> & _source, Stages _stages, unsigned int _windowsize) : 
+			DataSource<T, N>(_windowsize), 
+			samples(_source), 
+			stages(move(_stages)), 
+			data(), 
+			raw(), 
+			start(0), 
+			chunk(0) 
+		{
+			setup(); 
+		}
+		
+		//Only for a compile-time windowsize
+		TransformSource(DataSource<T> & _source, Stages _stages) : 
+			DataSource<T, N>(), 
+			samples(_source), 
+			stages(move(_stages)), 
+			data(), 
+			raw(), 
+			start(0), 
+			chunk(0) 
+		{
+			setup(); 
+		}
+		
+		TransformSource(TransformSource<T, Stages, N> const & cpy) = delete; 
+		TransformSource<T, Stages, N>& operator =(const TransformSource<T, Stages, N>& cpy) = delete; 
+	
+		//Moving is fine, so support rvalue move and move assignment operators.
+		TransformSource(TransformSource<T, Stages, N> && mv) : 
+			DataSource<T, N>(mv.windowsize), 
+			samples(move(mv.samples)), 
+			stages(move(mv.stages)), 
+			data(move(mv.data)), 
+			raw(move(mv.raw)), 
+			start(mv.start), 
+			chunk(mv.chunk) 
+		{}
+		
+		~TransformSource() = default; 
+    
+		//get a pointer to the start of the window
+		T * get()  {
+			if(!fill()) throw TransformSourceInvalidException(); 
+			return data.data() + start;
+		}
+		
+		//Transforms more of the source, if need be, for k windows. 
+		WindowBatch<T> batch(unsigned int k) {
+			
+			if(!fill()) return WindowBatch<T>(nullptr, 0, this->getwindowsize()); 
+			
+			while(data.size() < start + this->getwindowsize() + k - 1 && !samples.finished()) more(); 
+			
+			unsigned int available = data.size() - start - this->getwindowsize() + 1; 
+			return WindowBatch<T>(data.data() + start, std::min(k, available), this->getwindowsize()); 
+			
+		}
+		
+		//increment the start pointer
+		void tick() { start++; }
+		
+		//check that the window is still valid
+		bool eods() { return !fill(); }
+		
+};
+
+//So that the type of the stages needn't be written out: 
+//	auto ts = transformsource(fs, scale(2.0) | clip(0.0, 10.0), 16); 
+template<class T, class Stages>
+inline TransformSource<T, Stages> transformsource(DataSource<T> & source, const Stage<Stages> & stages, unsigned int windowsize) {
+	return TransformSource<T, Stages>(source, stages.self(), windowsize); 
+}
+
+}
+
+#endif
@@ -27,54 +27,26 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 /* 
 The vector data source is simple; it takes in a vector of data (compiled by another class etc) and 
-utilises it as the data passed out through the window. 
+utilises it as the data passed out through the window. The vector is moved in, so pass it with 
+std::move() (or as a temporary) to avoid a copy. For huge pages or NUMA placement, build the vector 
+with a PageAllocator and give its type as Alloc. 
 */
 
 #ifndef VectorSource_HEADER
 #define VectorSource_HEADER
 
-#include <vector>
-#include <utility>
+#include <memory>
 
-#include "DataSource.hpp"
+#include "WindowedSource.hpp"
 
-using std::vector;
-using std::move; 
+using std::allocator;
 
 namespace libsim 
 {
 
-template<class T>
-class VectorSource : public DataSource<T> {
-	
-	protected:
-		vector<T> data;
-		unsigned int start; 
-
-	public:
-		VectorSource(vector<T> _data, unsigned int _windowsize) : DataSource<T>(_windowsize), data(_data), start(0) {}
-		
-		VectorSource(VectorSource<T> const & cpy) = delete; 
-		VectorSource<T>& operator =(const VectorSource<T>& cpy) = delete; 
-	
-		//Moving is fine, so support rvalue move and move assignment operators.
-		VectorSource(VectorSource<T> && mv) : DataSource<T>(mv.windowsize), data(move(mv.data)), start(mv.start) {}
-		VectorSource<T>& operator =(VectorSource<T> && mv) { data = move(mv.data); start = mv.start; return *this; }
-		~VectorSource() = default; 
-    
-		//get a pointer to the start of the window
-		T * get()  {
-			return data.data() + start;
-		}
-		
-		//increment the start pointer
-		void tick() { start++; }
-		
-		//check that the window is still valid
-		bool eods() { return start > (data.size() - this->windowsize); }
-		
-};
+template<class T, unsigned int N = 0, class Alloc = allocator<T>>
+using VectorSource = WindowedSource<T, OwnedStorage<T, Alloc>, N>; 
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,110 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* 
+A source that slides a window over a contiguous block of data that is already
+in memory (or mapped into it). Where the data lives is up to the Storage 
+policy; see Storage.hpp and MappedStorage.hpp. VectorSource, SharedSource and 
+MutableSource are this with the owned, borrowed and appendable policies. 
+*/
+
+#ifndef WindowedSource_HEADER
+#define WindowedSource_HEADER
+
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+
+#include "DataSource.hpp"
+#include "Storage.hpp"
+
+using std::move; 
+using std::size_t; 
+
+namespace libsim 
+{
+
+template<class T, class Storage, unsigned int N = 0>
+class WindowedSource : public DataSource<T, N> {
+	
+	protected:
+		Storage storage;
+		unsigned int start; 
+
+	public:
+		WindowedSource(Storage _storage, unsigned int _windowsize) : DataSource<T, N>(_windowsize), storage(move(_storage)), start(0) {}
+		
+		//For storage over a raw pointer
+		WindowedSource(T * _data, size_t _size, unsigned int _windowsize) : DataSource<T, N>(_windowsize), storage(_data, _size), start(0) {}
+		
+		//Only for a compile-time windowsize
+		WindowedSource(Storage _storage) : DataSource<T, N>(), storage(move(_storage)), start(0) {}
+		WindowedSource(T * _data, size_t _size) : DataSource<T, N>(), storage(_data, _size), start(0) {}
+		
+		WindowedSource(WindowedSource<T, Storage, N> const & cpy) = delete; 
+		WindowedSource<T, Storage, N>& operator =(const WindowedSource<T, Storage, N>& cpy) = delete; 
+	
+		//Moving is fine, so support rvalue move and move assignment operators.
+		WindowedSource(WindowedSource<T, Storage, N> && mv) : DataSource<T, N>(mv.windowsize), storage(move(mv.storage)), start(mv.start) {}
+		WindowedSource<T, Storage, N>& operator =(WindowedSource<T, Storage, N> && mv) { storage = move(mv.storage); start = mv.start; return *this; }
+		~WindowedSource() = default; 
+    
+		//get a pointer to the start of the window
+		T * get()  {
+			return storage.data() + start;
+		}
+		
+		//increment the start pointer
+		void tick() { start++; }
+		
+		//Every window to the end of the data is already in memory. 
+		WindowBatch<T> batch(unsigned int k) { 
+			if(eods()) return WindowBatch<T>(nullptr, 0, this->getwindowsize()); 
+			unsigned int available = storage.size() - this->getwindowsize() - start + 1; 
+			return WindowBatch<T>(get(), std::min(k, available), this->getwindowsize()); 
+		}
+		
+		//Only for storage that can grow
+		void push_back(T value) { storage.push_back(value); }
+		
+		SourceCheckpoint checkpoint() { 
+			return SourceCheckpoint(CheckpointKind::memory, this->getwindowsize(), start); 
+		}
+		
+		void restore(const SourceCheckpoint & cp) { 
+			cp.expect(CheckpointKind::memory, this->getwindowsize()); 
+			start = cp.index; 
+		}
+		
+		//check that the window is still valid
+		bool eods() { return start + this->getwindowsize() > storage.size(); }
+		
+};
+
+}
+
+#endif
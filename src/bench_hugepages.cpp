@@ -0,0 +1,205 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+Scans a large in-memory source with each MemoryPolicy and reports the 
+sequential bandwidth, the cost of windows at random positions, and the dTLB 
+misses of each (from perf_event_open; n/a if the kernel won't give them out). 
+
+	bench_hugepages [MB per run, default 1024] [threads, default all]
+
+Each thread first-touches, then scans, its own slice of the buffer, through a 
+SharedSource over memory from a PageAllocator. 
+
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "SharedSource.hpp"
+#include "PageAllocator.hpp"
+
+using std::cout; 
+using std::endl; 
+using std::vector;
+using std::thread;
+using std::string;
+
+using namespace libsim;
+
+typedef std::chrono::steady_clock benchclock; 
+
+//Counts dTLB load misses in this process, and the threads it starts. 
+class TLBCounter {
+	
+	private:
+		int fd; 
+	
+	public:
+		TLBCounter() : fd(-1) {
+			
+			struct perf_event_attr attr; 
+			memset(&attr, 0, sizeof(attr)); 
+			attr.size = sizeof(attr); 
+			attr.type = PERF_TYPE_HW_CACHE; 
+			attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16); 
+			attr.disabled = 1; 
+			attr.inherit = 1; 
+			attr.exclude_kernel = 1; 
+			attr.exclude_hv = 1; 
+			
+			fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0); 
+			
+		}
+		
+		~TLBCounter() { if(fd >= 0) close(fd); }
+		
+		void start() {
+			if(fd < 0) return; 
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0); 
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0); 
+		}
+		
+		string stop() {
+			
+			if(fd < 0) return "n/a"; 
+			
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0); 
+			
+			uint64_t count = 0; 
+			if(read(fd, &count, sizeof(count)) != sizeof(count)) return "n/a"; 
+			
+			return std::to_string(count); 
+			
+		}
+	
+};
+
+template<class F>
+double parallel(unsigned int threads, F f) {
+	
+	auto begin = benchclock::now(); 
+	
+	vector<thread> workers; 
+	for(unsigned int t = 0; t < threads; t++) workers.push_back(thread(f, t)); 
+	for(auto & w : workers) w.join(); 
+	
+	return std::chrono::duration<double>(benchclock::now() - begin).count(); 
+	
+}
+
+void run(const string & name, const MemoryPolicy & policy, size_t count, unsigned int threads) {
+	
+	const unsigned int WINDOW = 16; 
+	const size_t LOOKUPS = 4 << 20; 
+	
+	size_t slice = count / threads; 
+	
+	//A vector would touch every page from this thread as it is constructed; 
+	//allocate directly and let each worker write its own slice instead. 
+	PageAllocator<double> alloc(policy); 
+	double * base = alloc.allocate(count); 
+	
+	double filltime = parallel(threads, [=](unsigned int t) {
+		for(size_t i = t * slice; i < (t + 1) * slice; i++) base[i] = (double) (i & 1023); 
+	});
+	
+	auto source = SharedSource<double, WINDOW>(base, slice * threads); 
+	double * window = source.get(); 
+	
+	vector<double> sums(threads * 8, 0.0); 
+	
+	TLBCounter seqtlb; 
+	seqtlb.start(); 
+	double seqtime = parallel(threads, [&, window](unsigned int t) {
+		double sum = 0.0; 
+		for(size_t i = t * slice; i < (t + 1) * slice; i++) sum += window[i]; 
+		sums[t * 8] += sum; 
+	});
+	string seqmisses = seqtlb.stop(); 
+	
+	TLBCounter randtlb; 
+	randtlb.start(); 
+	double randtime = parallel(threads, [&, window](unsigned int t) {
+		double sum = 0.0; 
+		uint64_t x = 88172645463325252ull + t; 
+		for(size_t i = 0; i < LOOKUPS; i++) {
+			x ^= x << 13; x ^= x >> 7; x ^= x << 17; 
+			size_t at = t * slice + x % (slice - WINDOW); 
+			for(unsigned int j = 0; j < WINDOW; j++) sum += window[at + j]; 
+		}
+		sums[t * 8 + 1] += sum; 
+	});
+	string randmisses = randtlb.stop(); 
+	
+	double bytes = (double) slice * threads * sizeof(double); 
+	
+	cout << std::left << std::setw(26) << name 
+		<< std::setw(12) << std::fixed << std::setprecision(2) << bytes / filltime / 1e9 
+		<< std::setw(12) << bytes / seqtime / 1e9 
+		<< std::setw(14) << seqmisses 
+		<< std::setw(12) << randtime * 1e9 / (LOOKUPS * threads) 
+		<< std::setw(14) << randmisses 
+		<< (sums[0] + sums[1] == -1.0 ? "!" : "") << endl; 
+	
+	alloc.deallocate(base, count); 
+	
+}
+
+int main(int argc, char ** argv) {
+	
+	size_t mb = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1024; 
+	unsigned int threads = argc > 2 ? strtoul(argv[2], nullptr, 10) : thread::hardware_concurrency(); 
+	if(threads == 0) threads = 1; 
+	
+	size_t count = (mb << 20) / sizeof(double); 
+	
+	cout << mb << "MB, " << threads << " threads, node " << PageMapper::currentnode() << endl; 
+	cout << std::left << std::setw(26) << "policy" << std::setw(12) << "fill GB/s" << std::setw(12) << "scan GB/s" 
+		<< std::setw(14) << "scan dTLB" << std::setw(12) << "random ns" << std::setw(14) << "random dTLB" << endl; 
+	
+	run("4KB pages", MemoryPolicy(PageMode::normal, NumaMode::firsttouch, 0, 0), count, threads); 
+	run("transparent huge", MemoryPolicy(PageMode::transparent, NumaMode::firsttouch, 0, 0), count, threads); 
+	run("hugetlb", MemoryPolicy(PageMode::hugetlb, NumaMode::firsttouch, 0, 0), count, threads); 
+	run("transparent, local", MemoryPolicy(PageMode::transparent, NumaMode::local, 0, 0), count, threads); 
+	run("transparent, interleave", MemoryPolicy(PageMode::transparent, NumaMode::interleave, 0, 0), count, threads); 
+	
+	return 0; 
+	
+}
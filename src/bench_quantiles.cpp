@@ -0,0 +1,117 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+
+Times the median of every window of a random series, by SlidingQuantile and by
+the usual copy-and-sort of each window (which is what gsl_stats_median does), 
+for a range of windowsizes. Sorting big windows is slow, so the baseline is 
+only timed over the first 5000 windows. 
+
+	bench_quantiles [elements, default 200000]
+
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+#include <cmath>
+
+#include "VectorSource.hpp"
+#include "SlidingQuantile.hpp"
+
+using std::cout; 
+using std::endl; 
+using std::vector;
+
+using namespace libsim;
+
+typedef std::chrono::steady_clock benchclock; 
+
+int main(int argc, char ** argv) {
+	
+	size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200000; 
+	
+	std::mt19937 rng(42); 
+	std::normal_distribution<double> noise(0.0, 1.0); 
+	
+	vector<double> data(count); 
+	for(auto & d : data) d = noise(rng); 
+	
+	cout << std::left << std::setw(10) << "window" << std::setw(18) << "sort ns/tick" << std::setw(18) << "skiplist ns/tick" << std::setw(10) << "speedup" << endl; 
+	
+	unsigned int sizes[] = { 16, 64, 256, 1024, 4096, 16384 }; 
+	
+	for(auto w : sizes) {
+		
+		if(w >= count) break; 
+		
+		size_t windows = count - w + 1; 
+		size_t sorted = std::min<size_t>(windows, 5000); 
+		double check = 0.0; 
+		
+		//Baseline: copy each window and sort it. 
+		auto t0 = benchclock::now(); 
+		{
+			auto vs = VectorSource<double>(vector<double>(data.begin(), data.begin() + sorted + w - 1), w); 
+			vector<double> scratch(w); 
+			while(!vs.eods()) {
+				std::copy(vs.get(), vs.get() + w, scratch.begin()); 
+				std::sort(scratch.begin(), scratch.end()); 
+				check += (w % 2) ? scratch[w / 2] : 0.5 * (scratch[w / 2 - 1] + scratch[w / 2]); 
+				vs.tick(); 
+			}
+		}
+		double sorttime = std::chrono::duration<double>(benchclock::now() - t0).count(); 
+		
+		auto t1 = benchclock::now(); 
+		{
+			auto vs = VectorSource<double>(vector<double>(data), w); 
+			auto sq = SlidingQuantile<double>(vs); 
+			for(size_t i = 0; !sq.eods(); i++) {
+				double m = sq.median(); 
+				if(i < sorted) check -= m; 
+				sq.tick(); 
+			}
+		}
+		double skiptime = std::chrono::duration<double>(benchclock::now() - t1).count(); 
+		
+		cout << std::left << std::setw(10) << w << std::fixed << std::setprecision(1) 
+			<< std::setw(18) << sorttime * 1e9 / sorted 
+			<< std::setw(18) << skiptime * 1e9 / windows 
+			<< std::setw(10) << (sorttime / sorted) / (skiptime / windows) 
+			<< (std::abs(check) > 1e-6 ? " (medians differ!)" : "") << endl; 
+		
+	}
+	
+	return 0; 
+	
+}
@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2013, Richard Martin
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of Richard Martin nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL RICHARD MARTIN BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+//Coroutines need C++20, so these tests are built on their own; the rest are 
+//in main.cpp, which is C++11. 
+
+#define BOOST_TEST_MAIN 
+#include <boost/test/included/unit_test.hpp>
+
+#include <functional>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <coroutine>
+
+#include "FileSource.hpp"
+#include "Awaitable.hpp"
+
+using std::vector;
+using std::launch;
+using std::unique_ptr;
+
+using namespace libsim;
+
+//As in main.cpp: work posted from any thread, run on this one. 
+class EventLoop {
+	
+	private:
+		std::mutex lock; 
+		std::condition_variable wake; 
+		std::deque<std::function<void()>> work; 
+	
+	public:
+		void post(std::function<void()> fn) {
+			{
+				std::lock_guard<std::mutex> guard(lock); 
+				work.push_back(move(fn)); 
+			}
+			wake.notify_one(); 
+		}
+		
+		std::function<void()> next() {
+			std::unique_lock<std::mutex> guard(lock); 
+			wake.wait(guard, [this]() { return !work.empty(); }); 
+			auto fn = move(work.front()); 
+			work.pop_front(); 
+			return fn; 
+		}
+		
+};
+
+//Just enough of a coroutine type to start one and let it run. 
+struct Detached {
+	struct promise_type {
+		Detached get_return_object() { return Detached(); }
+		std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+		std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+Detached consume(FileSource<unsigned int> & fs, EventLoop & loop, unsigned int & windows, unsigned int & finished) {
+	
+	while(unsigned int * w = co_await awaitwindow(fs, [&loop](std::function<void()> fn) { loop.post(move(fn)); })) {
+		if(w[0] == windows) windows++; 
+		fs.tick(); 
+	}
+	
+	finished++; 
+	
+}
+
+BOOST_AUTO_TEST_CASE(coroutine_test) {
+	
+	const unsigned int count = 16; 
+	
+	vector<unique_ptr<FileSource<unsigned int>>> sources; 
+	vector<unsigned int> windows(count, 0); 
+	unsigned int finished = 0; 
+	EventLoop loop; 
+	
+	for(unsigned int i = 0; i < count; i++) {
+		sources.push_back(unique_ptr<FileSource<unsigned int>>(new FileSource<unsigned int>("test/data", 5, launch::async))); 
+		consume(*sources.back(), loop, windows[i], finished); 
+	}
+	
+	while(finished < count) loop.next()(); 
+	
+	for(unsigned int i = 0; i < count; i++) BOOST_CHECK_EQUAL(37, windows[i]); 
+	
+}
@@ -33,19 +33,50 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <future>
 #include <functional>
 #include <vector>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+#include <atomic>
+#include <sstream>
+#include <numeric>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/wait.h>
 
 #include "FileSource.hpp"
 #include "VectorSource.hpp"
 #include "SharedSource.hpp"
 #include "RingSource.hpp"
 #include "SQLiteSource.hpp"
+#include "SQLiteLoaders.hpp"
 #include "MutableSource.hpp"
+#include "MultiFileSource.hpp"
+#include "SharedMemorySource.hpp"
+#include "RandomAccessSource.hpp"
+#include "MappedStorage.hpp"
+#include "PageAllocator.hpp"
+#include "TransformSource.hpp"
+#include "MergeSource.hpp"
+#include "SlidingDFT.hpp"
+#include "SlidingQuantile.hpp"
+#include "SlidingCorrelation.hpp"
+#include "ParallelMap.hpp"
+#include "QuantisedSource.hpp"
+#include "CompressedSource.hpp"
+#include "RasterSource.hpp"
 
 using std::cout; 
 using std::endl; 
 using std::future; 
 using std::async;
 using std::vector;
+using std::launch;
 
 using namespace libsim;
 
@@ -87,6 +118,308 @@ BOOST_AUTO_TEST_CASE(filesource_test2) {
 	
 }
 
+BOOST_AUTO_TEST_CASE(filesource_cancel_test) {
+	
+	auto fs = FileSource<unsigned int>("test/data", 5, launch::async);
+	
+	for(unsigned int i = 0 ; i < 7; i++)  {
+		BOOST_CHECK_EQUAL(i, fs.get()[0]);
+		fs.tick();
+	}
+	
+	fs.cancel();
+	
+	BOOST_CHECK(fs.eods());
+	BOOST_CHECK_THROW(fs.get(), AsyncIOInvalidException);
+	
+	//Destroying with io still outstanding must not touch the closed file.
+	{
+		auto early = FileSource<unsigned int>("test/data", 5, launch::async);
+		early.tick();
+	}
+	
+}
+
+BOOST_AUTO_TEST_CASE(filesource_follow_test) {
+	
+	string fn = "/tmp/libsimwindow_follow_" + std::to_string(getpid()); 
+	
+	{
+		std::ofstream out(fn); 
+		out << "0\n1\n2\n3\n4" << std::flush; 
+	}
+	
+	auto fs = FileSource<unsigned int>(fn, 3, launch::async, FileSourceMode::follow); 
+	
+	//The last line isn't finished, so only 0 to 3 are available. 
+	for(unsigned int i = 0 ; i < 2; i++)  {
+		BOOST_CHECK(!fs.eods());
+		for (unsigned int j = 0 ; j < 3; j++) {
+			BOOST_CHECK_EQUAL(i+j, fs.get()[j]);
+		}
+		fs.tick();
+	}
+	
+	auto writer = std::thread([&fn]() { 
+		std::ofstream out(fn, std::ios::app); 
+		for(unsigned int i = 0 ; i < 10; i++) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(2)); 
+			if(i == 0) out << "\n" << std::flush; 
+			else out << (4 + i) << "\n" << std::flush; 
+		}
+	}); 
+	
+	//Blocks until the writer catches up. 
+	for(unsigned int i = 2 ; i <= 11; i++)  {
+		BOOST_CHECK(!fs.eods());
+		for (unsigned int j = 0 ; j < 3; j++) {
+			BOOST_CHECK_EQUAL(i+j, fs.get()[j]);
+		}
+		fs.tick();
+	}
+	
+	writer.join(); 
+	
+	//Nothing more is coming: the outstanding wait is interrupted. 
+	fs.cancel(); 
+	BOOST_CHECK(fs.eods()); 
+	
+	//With a datapoint limit it stops on its own once the limit is read.
+	auto limited = FileSource<unsigned int>(fn, 3, launch::async, 8, FileSourceMode::follow);
+
+	for(unsigned int i = 0 ; i < 6; i++)  {
+		BOOST_CHECK(!limited.eods());
+		for (unsigned int j = 0 ; j < 3; j++) {
+			BOOST_CHECK_EQUAL(i+j, limited.get()[j]);
+		}
+		limited.tick();
+	}
+
+	BOOST_CHECK(limited.eods()); 
+	
+	std::remove(fn.c_str()); 
+	
+}
+
+BOOST_AUTO_TEST_CASE(filesource_parallel_test) {
+	
+	//test/data holds 0 to 40
+	for(unsigned int threads = 1; threads <= 4; threads++) {
+		
+		auto fs = FileSource<unsigned int>("test/data", 5, launch::async, FileSourceMode::parallel, threads);
+		
+		for(unsigned int i = 0 ; i < 37; i++) {
+			BOOST_CHECK(!fs.eods());
+			for (unsigned int j = 0 ; j < 5; j++) {
+				BOOST_CHECK_EQUAL(i+j, fs.get()[j]);
+			}
+			fs.tick();
+		}
+		
+		BOOST_CHECK(fs.eods());
+		
+	}
+	
+	//Big enough for several loads, lines of different lengths and no 
+	//newline at the end. 
+	string fn = "/tmp/libsimwindow_parallel_" + std::to_string(getpid()); 
+	{
+		std::ofstream out(fn); 
+		for(unsigned int i = 0; i < 200000; i++) {
+			if(i > 0) out << "\n"; 
+			out << (i * 7919) % 100003 << "." << i % 10; 
+		}
+	}
+	
+	auto serial = FileSource<double>(fn, 100);
+	auto parallel = FileSource<double>(fn, 100, launch::async, FileSourceMode::parallel, 3);
+	
+	unsigned int windows = 0; 
+	SourceCheckpoint cp(CheckpointKind::file, 100, 0); 
+	
+	while(!serial.eods()) {
+		BOOST_CHECK(!parallel.eods());
+		if(!std::equal(serial.get(), serial.get() + 100, parallel.get())) {
+			BOOST_ERROR("window " << windows << " differs"); 
+			break; 
+		}
+		if(windows == 123456) cp = parallel.checkpoint(); 
+		serial.tick(); 
+		parallel.tick(); 
+		windows++; 
+	}
+	
+	BOOST_CHECK_EQUAL(200000 - 99, windows); 
+	BOOST_CHECK(parallel.eods());
+	
+	//Loads stay within the read bounds. 
+	{
+		auto bounded = FileSource<double>(fn, 100, launch::async, FileSourceMode::parallel, 2);
+		bounded.setreadbounds(256, 256); 
+		
+		size_t most = 0; 
+		for(unsigned int i = 0; i < 20000; i++) {
+			if(i % 1000 == 0) BOOST_CHECK_CLOSE((i * 7919) % 100003 + (i % 10) / 10.0 + 1.0, bounded.get()[0] + 1.0, 1e-9); 
+			most = std::max(most, bounded.getheld()); 
+			bounded.tick(); 
+		}
+		BOOST_CHECK(most < 16 * 1024); 
+	}
+	
+	auto resumed = FileSource<double>(fn, 100, launch::async, FileSourceMode::parallel, 2);
+	resumed.restore(cp); 
+	BOOST_CHECK_CLOSE((123456.0 * 7919) - std::floor(123456.0 * 7919 / 100003) * 100003 + 0.6, resumed.get()[0], 1e-9); 
+	
+	std::remove(fn.c_str()); 
+	
+}
+
+BOOST_AUTO_TEST_CASE(sharedparse_test) {
+	
+	//On without being asked for. 
+	BOOST_CHECK(ParseRegistry::instance().isenabled()); 
+	
+	unsigned long before = ParseRegistry::instance().getshared(); 
+	
+	{
+		//test/data holds 0 to 40; different windowsizes still share. 
+		auto a = FileSource<unsigned int>("test/data", 5, launch::async);
+		auto b = FileSource<unsigned int>("test/data", 5, launch::async);
+		auto c = FileSource<unsigned int>("test/data", 8);
+		
+		//A different type is a different parse. 
+		auto d = FileSource<double>("test/data", 5);
+		
+		BOOST_CHECK_EQUAL(before + 2, ParseRegistry::instance().getshared()); 
+		BOOST_CHECK_EQUAL(2, ParseRegistry::instance().getparses()); 
+		
+		//At different paces. 
+		for(unsigned int i = 0 ; i < 37; i++) {
+			for (unsigned int j = 0 ; j < 5; j++) {
+				BOOST_CHECK_EQUAL(i+j, a.get()[j]);
+			}
+			a.tick();
+			
+			if(i % 2 == 0) {
+				BOOST_CHECK_EQUAL(i / 2, b.get()[0]);
+				b.tick(); 
+			}
+			
+			if(i < 34) {
+				BOOST_CHECK_EQUAL(i + 7, c.get()[7]);
+				c.tick(); 
+			}
+		}
+		
+		BOOST_CHECK(a.eods());
+		BOOST_CHECK(!b.eods());
+		BOOST_CHECK(c.eods());
+		BOOST_CHECK_EQUAL(0.0, d.get()[0]);
+		
+		//A restored source reads the file itself. 
+		auto cp = a.checkpoint(); 
+		BOOST_CHECK_EQUAL(37, cp.index); 
+		auto e = FileSource<unsigned int>("test/data", 3);
+		SourceCheckpoint thirty(CheckpointKind::file, 3, 30); 
+		thirty.base = 0; 
+		e.restore(thirty); 
+		BOOST_CHECK_EQUAL(30, e.get()[0]);
+		BOOST_CHECK_EQUAL(32, e.get()[2]);
+	}
+	
+	BOOST_CHECK_EQUAL(0, ParseRegistry::instance().getparses()); 
+	
+	//Once everyone is past the first chunk, a new source starts its own parse.
+	string fn = "/tmp/libsimwindow_shared_" + std::to_string(getpid()); 
+	{
+		std::ofstream out(fn); 
+		for(unsigned int i = 0; i < 100000; i++) out << i << "\n"; 
+	}
+	
+	{
+		auto early = FileSource<unsigned int>(fn, 10);
+		for(unsigned int i = 0; i < 70000; i++) early.tick(); 
+		BOOST_CHECK_EQUAL(70000, early.get()[0]); 
+		
+		unsigned long joined = ParseRegistry::instance().getshared(); 
+		auto late = FileSource<unsigned int>(fn, 10);
+		BOOST_CHECK_EQUAL(0, late.get()[0]); 
+		BOOST_CHECK_EQUAL(joined, ParseRegistry::instance().getshared()); 
+		BOOST_CHECK_EQUAL(70001, early.get()[1]); 
+	}
+	
+	//A source that falls too far behind goes back to the file, rather than 
+	//keeping everything the others have read since. 
+	{
+		unsigned long detached = ParseRegistry::instance().getdetached(); 
+		
+		auto fast = FileSource<unsigned int>(fn, 10);
+		auto slow = FileSource<unsigned int>(fn, 10);
+		BOOST_CHECK_EQUAL(0, slow.get()[0]); 
+		
+		//The chunks between them are charged to the governor. 
+		for(unsigned int i = 0; i < 30000; i++) fast.tick(); 
+		BOOST_CHECK_EQUAL(30000, fast.get()[0]); 
+		BOOST_CHECK(BufferGovernor::instance().getusage() >= fast.getheld() + slow.getheld() + 28000 * sizeof(unsigned int)); 
+		
+		for(unsigned int i = 30000; i < 90000; i++) fast.tick(); 
+		BOOST_CHECK_EQUAL(90000, fast.get()[0]); 
+		
+		unsigned int windows = 0; 
+		for( ; !slow.eods(); windows++) {
+			if(slow.get()[0] != windows) {
+				BOOST_ERROR("window " << windows << " differs"); 
+				break; 
+			}
+			slow.tick(); 
+		}
+		
+		BOOST_CHECK_EQUAL(100000 - 9, windows); 
+		BOOST_CHECK_EQUAL(detached + 1, ParseRegistry::instance().getdetached()); 
+	}
+	
+	std::remove(fn.c_str()); 
+	
+	ParseRegistry::instance().setenabled(false); 
+	
+	auto f = FileSource<unsigned int>("test/data", 5);
+	auto g = FileSource<unsigned int>("test/data", 5);
+	BOOST_CHECK_EQUAL(0, ParseRegistry::instance().getparses()); 
+	
+	ParseRegistry::instance().setenabled(true); 
+	
+}
+
+BOOST_AUTO_TEST_CASE(multifilesource_test) {
+	
+	//test/data holds 0 to 40, so the stream is 0..40 twice
+	auto fs = MultiFileSource<unsigned int>(vector<string>{ "test/data", "test/data" }, 5, launch::async);
+	
+	for(unsigned int i = 0 ; i < 78; i++) {
+		
+		BOOST_CHECK(!fs.eods());
+		
+		for (unsigned int j = 0 ; j < 5; j++) {
+			BOOST_CHECK_EQUAL((i+j) % 41, fs.get()[j]);
+		}
+		
+		fs.tick();
+		
+	}
+	
+	BOOST_CHECK(fs.eods());
+	
+	auto gs = MultiFileSource<unsigned int>(string("test/dat[a]"), 5);
+	
+	for(unsigned int i = 0 ; i <= 36; i++) {
+		BOOST_CHECK_EQUAL(i, gs.get()[0]);
+		gs.tick();
+	}
+	
+	BOOST_CHECK(gs.eods());
+	
+}
+
 // Vectors
 
 BOOST_AUTO_TEST_CASE(vectorsource_test) {
@@ -171,53 +504,1515 @@ BOOST_AUTO_TEST_CASE(sharedsource_test) {
 	
 }
 
-// Ring
+// Storage policies
 
-BOOST_AUTO_TEST_CASE(ringsource_test) {
+BOOST_AUTO_TEST_CASE(storage_test) {
 	
 	auto data = vector<unsigned int>();
-	for(unsigned int i = 0; i < 6; i++) {
+	for(unsigned int i = 0; i < 30; i++) {
 		data.push_back(i);
 	}
 	
-	auto fs = RingSource<unsigned int>(data, 5);
+	//Moved in, and moved again, the buffer is never copied. 
+	unsigned int * buffer = data.data(); 
+	auto vs = VectorSource<unsigned int>(move(data), 5);
+	auto vm = move(vs); 
+	BOOST_CHECK_EQUAL(buffer, vm.get()); 
 	
-	for(unsigned int i = 0 ; i <= 12; i++)  {
+	auto ms = MutableSource<unsigned int>(vector<unsigned int>(3, 7), 5);
+	BOOST_CHECK(ms.eods()); 
+	ms.push_back(7); 
+	ms.push_back(7); 
+	BOOST_CHECK(!ms.eods()); 
+	
+	unsigned int * mbuffer = ms.get(); 
+	auto mm = move(ms); 
+	BOOST_CHECK_EQUAL(mbuffer, mm.get()); 
+	
+	string fn = "/tmp/libsim_mapped_test"; 
+	{
+		std::ofstream out(fn, std::ios::binary); 
+		for(unsigned int i = 0; i < 30; i++) {
+			double d = i; 
+			out.write(reinterpret_cast<const char *>(&d), sizeof(double)); 
+		}
+	}
+	
+	auto fs = MappedSource<double>(fn.c_str(), 5);
+	
+	for(unsigned int i = 0 ; i <= 25; i++)  {
+	
+		BOOST_CHECK(!fs.eods());
 		
 		for (unsigned int j = 0 ; j < 5; j++) {
-			BOOST_CHECK_EQUAL((i+j) % 6, fs.get()[j]);
+			BOOST_CHECK_EQUAL(i+j, fs.get()[j]);
 		}
 		
 		fs.tick();
 		
 	}
 	
+	BOOST_CHECK(fs.eods());
+	
+	BOOST_CHECK_THROW(MappedStorage<double>("/tmp/libsim_no_such_file"), MappedStorageInvalidException);
+	
+	std::remove(fn.c_str()); 
+	
 }
 
-// Sqlite
+// Page allocation
 
-BOOST_AUTO_TEST_CASE(sqlite3_test) {
+BOOST_AUTO_TEST_CASE(pageallocator_test) {
+	
+	MemoryPolicy policies[] = {
+		MemoryPolicy(PageMode::transparent, NumaMode::firsttouch, 0, 0), 
+		MemoryPolicy(PageMode::hugetlb, NumaMode::local, 0, 0), 
+		MemoryPolicy(PageMode::normal, NumaMode::node, 0, 0), 
+		MemoryPolicy(PageMode::normal, NumaMode::interleave, 0, 0)
+	};
+	
+	for(auto & policy : policies) {
+		
+		auto data = vector<double, PageAllocator<double>>(PageAllocator<double>(policy));
+		for(unsigned int i = 0; i < 300000; i++) {
+			data.push_back(i);
+		}
+		
+		if(policy.pages != PageMode::normal) {
+			BOOST_CHECK_EQUAL(0u, reinterpret_cast<uintptr_t>(data.data()) % PageMapper::hugepage()); 
+		}
+		
+		auto vs = VectorSource<double, 0, PageAllocator<double>>(move(data), 5);
+		
+		for(unsigned int i = 0 ; i <= 299995; i += 997)  {
+			BOOST_CHECK_EQUAL(i, vs.get()[0]);
+			for(unsigned int j = 0; j < 997; j++) vs.tick(); 
+		}
+		
+	}
+	
+	//The default policy is picked up by the library's own buffers. 
+	MemoryPolicy::setdefault(MemoryPolicy(PageMode::transparent, NumaMode::firsttouch, 0, 0)); 
+	
+	auto data = vector<unsigned int>();
+	for(unsigned int i = 0; i < 6; i++) {
+		data.push_back(i);
+	}
+	
+	auto rs = RingSource<unsigned int>(data, 5);
+	BOOST_CHECK_EQUAL(0u, reinterpret_cast<uintptr_t>(rs.get()) % PageMapper::hugepage()); 
+	
+	auto fs = FileSource<unsigned int>("test/data", 5);
+	for(unsigned int i = 0 ; i <= 36; i++)  {
+		BOOST_CHECK_EQUAL(i, fs.get()[0]);
+		fs.tick();
+	}
+	
+	MemoryPolicy::setdefault(MemoryPolicy()); 
+	
+	BOOST_CHECK(PageAllocator<int>() == PageAllocator<double>()); 
+	
+}
 
-  
-	sqlite3 * database;
-	sqlite3_open("test/testdb", &database);
+// Transforms
+
+BOOST_AUTO_TEST_CASE(transform_test) {
 	
-	string sql = "SELECT * from test LIMIT ? OFFSET ?;";
+	auto fs = FileSource<double>("test/data", 1);
+	auto ts = transformsource(fs, scale(2.0, 1.0) | where([](double v) { return v < 60.0; }) | clip(0.0, 50.0), 5);
 	
-	auto fs = SQLiteSource<unsigned int>(database, sql, 5);
+	for(unsigned int i = 0 ; i <= 25; i++)  {
 	
-	for(unsigned int i = 1 ; i <= 40; i++)  {
+		BOOST_CHECK(!ts.eods());
 		
 		for (unsigned int j = 0 ; j < 5; j++) {
-			BOOST_CHECK_EQUAL(i+j, fs.get()[j]);
+			BOOST_CHECK_EQUAL(std::min(2.0 * (i+j) + 1.0, 50.0), ts.get()[j]);
 		}
 		
-		fs.tick();
+		ts.tick();
 		
 	}
 	
-	sqlite3_close(database);
+	BOOST_CHECK(ts.eods());
+	BOOST_CHECK_THROW(ts.get(), TransformSourceInvalidException);
+	
+	//Every element of the source is read once, whatever its windowsize. 
+	auto data = vector<unsigned int>();
+	for(unsigned int i = 0; i < 10; i++) {
+		data.push_back(i);
+	}
+	
+	auto vs = VectorSource<unsigned int>(data, 3);
+	auto ss = TransformSource<unsigned int, ApplyStage<unsigned int (*)(unsigned int)>, 4>(vs, apply(+[](unsigned int v) { return v * v; }));
+	
+	for(unsigned int i = 0 ; i <= 6; i++)  {
+		
+		BOOST_CHECK(!ss.eods());
+		
+		auto w = ss.window(); 
+		for (unsigned int j = 0 ; j < w.size(); j++) {
+			BOOST_CHECK_EQUAL((i+j) * (i+j), w[j]);
+		}
+		
+		ss.tick();
+		
+	}
+	
+	BOOST_CHECK(ss.eods());
+	
+	auto cs = VectorSource<double>(vector<double>(20, 3.0), 1);
+	auto ds = transformsource(cs, detrend(0.5), 5);
+	BOOST_CHECK_EQUAL(0.0, ds.get()[4]);
+	
+}
+
+// Batches of windows
+
+BOOST_AUTO_TEST_CASE(batch_test) {
+	
+	auto data = vector<unsigned int>();
+	for(unsigned int i = 0; i < 30; i++) {
+		data.push_back(i);
+	}
+	
+	auto vs = VectorSource<unsigned int>(data, 5);
+	
+	auto b = vs.batch(8); 
+	BOOST_CHECK_EQUAL(8u, b.rows()); 
+	BOOST_CHECK_EQUAL(5u, b.cols()); 
+	BOOST_CHECK_EQUAL(vs.get(), b.data()); 
+	BOOST_CHECK_EQUAL(11u, b(7, 4)); 
+	
+	auto packed = b.pack(); 
+	for(unsigned int r = 0; r < 8; r++) {
+		for(unsigned int c = 0; c < 5; c++) {
+			BOOST_CHECK_EQUAL(r + c, packed[r * 5 + c]); 
+		}
+	}
+	
+	for(unsigned int i = 0; i < 20; i++) vs.tick(); 
+	BOOST_CHECK_EQUAL(6u, vs.batch(8).rows()); 
+	
+	//A buffered source reads ahead for the whole batch. 
+	auto fs = FileSource<unsigned int>("test/data", 5);
+	fs.setreadbounds(5, 5); 
+	
+	unsigned int position = 0; 
+	
+	while(true) {
+		
+		auto fb = fs.batch(16); 
+		if(fb.rows() == 0) break; 
+		
+		for(unsigned int r = 0; r < fb.rows(); r++) {
+			for(unsigned int c = 0; c < fb.cols(); c++) {
+				BOOST_CHECK_EQUAL(position + r + c, fb.row(r)[c]); 
+			}
+		}
+		
+		position += fb.rows(); 
+		for(unsigned int r = 0; r < fb.rows(); r++) fs.tick(); 
+		
+	}
+	
+	BOOST_CHECK_EQUAL(37u, position); 
+	
+	auto rs = RingSource<unsigned int>(vector<unsigned int>(data.begin(), data.begin() + 6), 5);
+	rs.tick(); 
+	BOOST_CHECK_EQUAL(5u, rs.batch(8).rows()); 
+	BOOST_CHECK_EQUAL(0u, rs.batch(8)(4, 1)); 
+	
+	//Anything else gives at least the current window. 
+	auto ras = RandomAccessSource<unsigned int>("test/data", 5, 8);
+	BOOST_CHECK_EQUAL(1u, ras.batch(8).rows()); 
+	
+}
+
+// Sliding DFT
+
+BOOST_AUTO_TEST_CASE(slidingdft_test) {
+	
+	auto data = vector<double>();
+	for(unsigned int i = 0; i < 400; i++) {
+		data.push_back(std::sin(0.3 * i) + 0.01 * (i % 7));
+	}
+	
+	//The DFT of the window at start, the slow way. 
+	auto direct = [&](unsigned int start, unsigned int w, unsigned int k) {
+		std::complex<double> sum(0.0, 0.0); 
+		for(unsigned int n = 0; n < w; n++) {
+			sum += data[start + n] * std::polar(1.0, -2.0 * 3.14159265358979323846 * k * n / w); 
+		}
+		return sum; 
+	};
+	
+	//Whole spectrum, power of two, re-anchored every 50 updates. 
+	auto vs = VectorSource<double>(data, 16);
+	auto sd = SlidingDFT<double>(vs, 50);
+	
+	unsigned int position = 0; 
+	unsigned int strides[] = { 1, 1, 3, 1, 7, 20, 1, 2 }; 
+	
+	for(unsigned int round = 0; round < 20; round++) {
+		for(auto stride : strides) {
+			
+			for(unsigned int k = 0; k < 16; k++) {
+				BOOST_CHECK_SMALL(std::abs(direct(position, 16, k) - sd.spectrum()[k]), 1e-9); 
+			}
+			
+			if(position + stride + 16 > data.size()) break; 
+			
+			sd.tick(stride); 
+			position += stride; 
+			
+		}
+	}
+	
+	//A few bins of a window that isn't a power of two. 
+	auto gs = VectorSource<double>(data, 24);
+	auto gd = SlidingDFT<double>(gs, vector<unsigned int>{ 1, 5, 12 });
+	
+	for(position = 0; position < 300; position++) {
+		for(unsigned int b = 0; b < 3; b++) {
+			BOOST_CHECK_SMALL(std::abs(direct(position, 24, gd.getbins()[b]) - gd.spectrum()[b]), 1e-9); 
+		}
+		gd.tick(); 
+	}
+	
+	BOOST_CHECK_THROW(SlidingDFT<double>(gs, vector<unsigned int>{ 24 }), SlidingDFTInvalidException);
 	
 }
 
+// Sliding quantiles
+
+BOOST_AUTO_TEST_CASE(slidingquantile_test) {
+	
+	//Plenty of repeats, to exercise equal keys. 
+	auto data = vector<unsigned int>();
+	for(unsigned int i = 0; i < 500; i++) {
+		data.push_back((i * 7919) % 37);
+	}
+	
+	auto vs = VectorSource<unsigned int>(data, 21);
+	auto sq = SlidingQuantile<unsigned int>(vs);
+	
+	for(unsigned int i = 0; i + 21 <= data.size(); i++) {
+		
+		BOOST_CHECK(!sq.eods());
+		
+		vector<unsigned int> sorted(data.begin() + i, data.begin() + i + 21); 
+		std::sort(sorted.begin(), sorted.end()); 
+		
+		BOOST_CHECK_EQUAL(sorted[10], sq.median()); 
+		BOOST_CHECK_EQUAL(sorted[0], sq.at(0)); 
+		BOOST_CHECK_EQUAL(sorted[20], sq.at(20)); 
+		
+		auto qs = sq.quantiles(vector<double>{ 0.25, 0.9, 1.0 }); 
+		BOOST_CHECK_EQUAL(sorted[5], qs[0]); 
+		BOOST_CHECK_CLOSE((double) sorted[18], qs[1], 1e-9); 
+		BOOST_CHECK_EQUAL(sorted[20], qs[2]); 
+		
+		sq.tick(); 
+		
+	}
+	
+	BOOST_CHECK(sq.eods());
+	BOOST_CHECK_THROW(sq.median(), SlidingQuantileInvalidException);
+	
+	//Interpolation between ranks. 
+	auto ds = VectorSource<double>(vector<double>{ 4.0, 1.0, 3.0, 2.0 }, 4);
+	auto dq = SlidingQuantile<double>(ds);
+	BOOST_CHECK_CLOSE(2.5, dq.median(), 1e-9); 
+	BOOST_CHECK_CLOSE(1.3, dq.quantile(0.1), 1e-9); 
+	BOOST_CHECK_THROW(dq.quantile(1.5), SlidingQuantileInvalidException);
+	
+}
 
+BOOST_AUTO_TEST_CASE(slidingcorrelation_test) {
+	
+	//A large offset, to check the sums stay well conditioned. 
+	auto xs = vector<double>();
+	auto ys = vector<double>();
+	for(unsigned int i = 0; i < 300; i++) {
+		xs.push_back(1e6 + std::sin(i * 0.3) + ((i * 7919) % 13) * 0.05);
+		ys.push_back(2e6 - 3.0 * std::sin((i - 2) * 0.3) + ((i * 104729) % 17) * 0.1);
+	}
+	
+	//Different windowsizes, so the two sources are read at different rates.
+	auto vx = VectorSource<double>(xs, 5);
+	auto vy = VectorSource<double>(ys, 50);
+	
+	vector<int> lags { -3, 0, 2 }; 
+	auto sc = SlidingCorrelation<double>(vx, vy, 16, lags, 7);
+	
+	BOOST_CHECK_EQUAL(3, sc.getlags().size()); 
+	
+	unsigned int windows = 0; 
+	
+	for(unsigned int p = 0; p + 3 + 2 + 16 <= xs.size(); p++) {
+		
+		BOOST_CHECK(!sc.eods());
+		
+		const double * r = sc.correlations(); 
+		
+		for(unsigned int k = 0; k < lags.size(); k++) {
+			
+			double mx = 0.0, my = 0.0; 
+			for(unsigned int i = 0; i < 16; i++) {
+				mx += xs[p + 3 + i]; 
+				my += ys[p + 3 + lags[k] + i]; 
+			}
+			mx /= 16; 
+			my /= 16; 
+			
+			double sxy = 0.0, sxx = 0.0, syy = 0.0; 
+			for(unsigned int i = 0; i < 16; i++) {
+				double dx = xs[p + 3 + i] - mx; 
+				double dy = ys[p + 3 + lags[k] + i] - my; 
+				sxy += dx * dy; 
+				sxx += dx * dx; 
+				syy += dy * dy; 
+			}
+			
+			BOOST_CHECK_CLOSE(sxy / std::sqrt(sxx * syy), r[k], 1e-4); 
+			BOOST_CHECK_CLOSE(sxy / 15, sc.covariance(k), 1e-4); 
+			
+		}
+		
+		sc.tick(); 
+		windows++; 
+		
+	}
+	
+	BOOST_CHECK_EQUAL(280, windows); 
+	BOOST_CHECK(sc.eods());
+	BOOST_CHECK_THROW(sc.correlation(), SlidingCorrelationInvalidException);
+	
+	//b is a scaled copy of a two elements later. 
+	auto va = VectorSource<double>(vector<double>{ 1.0, 4.0, 2.0, 8.0, 5.0, 7.0 }, 1);
+	auto vb = VectorSource<double>(vector<double>{ 0.0, 0.0, -2.0, -8.0, -4.0, -16.0 }, 1);
+	auto ab = SlidingCorrelation<double>(va, vb, 4, vector<int>{ 2 });
+	BOOST_CHECK_CLOSE(-1.0, ab.correlation(), 1e-9); 
+	
+	auto vc = VectorSource<double>(vector<double>{ 1.0, 2.0 }, 1);
+	auto vd = VectorSource<double>(vector<double>{ 1.0, 2.0 }, 1);
+	BOOST_CHECK_THROW(SlidingCorrelation<double>(vc, vd, 1), SlidingCorrelationInvalidException);
+	
+	//Ticking without asking for anything still lets go of what's behind. 
+	auto long1 = vector<double>(100000); 
+	auto long2 = vector<double>(100000); 
+	for(unsigned int i = 0; i < 100000; i++) {
+		long1[i] = std::sin(i * 0.1); 
+		long2[i] = std::cos(i * 0.1); 
+	}
+	auto vl1 = VectorSource<double>(long1, 1);
+	auto vl2 = VectorSource<double>(long2, 1);
+	auto lc = SlidingCorrelation<double>(vl1, vl2, 32, vector<int>{ -5, 5 });
+	
+	size_t most = 0; 
+	unsigned int ticks = 0; 
+	while(!lc.eods()) {
+		most = std::max(most, lc.getbuffered()); 
+		lc.tick(); 
+		ticks++; 
+	}
+	BOOST_CHECK_EQUAL(100000 - 10 - 31, ticks); 
+	BOOST_CHECK(most < 8 * 1024); 
+	
+}
+
+BOOST_AUTO_TEST_CASE(parallelmap_test) {
+	
+	auto data = vector<unsigned int>();
+	for(unsigned int i = 0; i < 2000; i++) {
+		data.push_back((i * 7919) % 1009);
+	}
+	
+	auto sum = [](const unsigned int * w, unsigned int n) {
+		unsigned long total = 0; 
+		for(unsigned int i = 0; i < n; i++) total += w[i]; 
+		//Some windows cost far more than others, so that tasks get stolen. 
+		if(w[0] % 5 == 0) {
+			//The fence keeps the loop from being optimised away. 
+			for(unsigned int spin = 0; spin < 20000; spin++) std::atomic_signal_fence(std::memory_order_seq_cst); 
+		}
+		return total; 
+	};
+	
+	auto vs = VectorSource<unsigned int>(data, 10);
+	auto pm = parallel_map(vs, sum, 4, 7);
+	
+	BOOST_CHECK_EQUAL(4, pm.getthreads()); 
+	
+	unsigned int windows = 0; 
+	for(unsigned int i = 0; i + 10 <= data.size(); i++) {
+		BOOST_CHECK(!pm.eods()); 
+		BOOST_CHECK_EQUAL(std::accumulate(data.begin() + i, data.begin() + i + 10, 0ul), pm.get()); 
+		pm.tick(); 
+		windows++; 
+	}
+	
+	BOOST_CHECK_EQUAL(1991, windows); 
+	BOOST_CHECK(pm.eods()); 
+	BOOST_CHECK_THROW(pm.get(), ParallelMapInvalidException); 
+	
+	//Through a FileSource, which keeps prefetching while the workers run. 
+	auto fs = FileSource<unsigned int>("test/data", 100);
+	auto check = FileSource<unsigned int>("test/data", 100);
+	auto fm = parallel_map(fs, [](const unsigned int * w, unsigned int n) { return *std::max_element(w, w + n); }, 3);
+	
+	while(!check.eods()) {
+		BOOST_CHECK(!fm.eods()); 
+		BOOST_CHECK_EQUAL(*std::max_element(check.get(), check.get() + 100), fm.get()); 
+		fm.tick(); 
+		check.tick(); 
+	}
+	BOOST_CHECK(fm.eods()); 
+	
+	//An exception from the function comes back with its window only, even 
+	//with other windows in the same task. 
+	auto es = VectorSource<unsigned int>(vector<unsigned int>{ 1, 2, 3, 4, 5, 6 }, 2);
+	auto em = parallel_map(es, [](const unsigned int * w, unsigned int) -> bool { 
+		if(w[0] == 1 || w[0] == 3) throw std::runtime_error("odd"); 
+		return w[0] % 2 == 0; 
+	}, 2, 4);
+	
+	BOOST_CHECK_THROW(em.get(), std::runtime_error); 
+	em.tick(); 
+	BOOST_CHECK_EQUAL(true, em.get()); 
+	em.tick(); 
+	BOOST_CHECK_THROW(em.get(), std::runtime_error); 
+	em.tick(); 
+	BOOST_CHECK_EQUAL(true, em.get()); 
+	em.tick(); 
+	BOOST_CHECK_EQUAL(false, em.get()); 
+	em.tick(); 
+	BOOST_CHECK(em.eods()); 
+	
+	//Abandoned part way, with the workers still busy. 
+	auto as = VectorSource<unsigned int>(data, 10);
+	{
+		auto am = parallel_map(as, sum, 2, 3);
+		am.get(); 
+	}
+	
+}
+
+BOOST_AUTO_TEST_CASE(quantised_test) {
+	
+	//Like 12 bit samples, scaled to volts. 
+	auto samples = vector<double>();
+	for(unsigned int i = 0; i < 5000; i++) {
+		samples.push_back(std::floor(2047.0 * std::sin(i * 0.01) + 0.5) * 0.001 + 3.3);
+	}
+	
+	auto qs = QuantisedSource<double>(samples, 100);
+	
+	BOOST_CHECK_EQUAL(samples.size(), qs.size()); 
+	BOOST_CHECK(qs.bytes() * 3 < samples.size() * sizeof(double)); 
+	
+	double error = qs.getcodec().geterror(); 
+	//Well inside the 1mV the samples were taken to. 
+	BOOST_CHECK(error < 0.0005); 
+	
+	unsigned int windows = 0; 
+	while(!qs.eods()) {
+		double * w = qs.get(); 
+		for(unsigned int i = 0; i < 100; i++) {
+			BOOST_CHECK_SMALL(w[i] - samples[windows + i], error + 1e-12); 
+		}
+		qs.tick(); 
+		windows++; 
+	}
+	BOOST_CHECK_EQUAL(samples.size() - 99, windows); 
+	
+	//Integers that each block can span exactly; a window bigger than a block. 
+	auto counts = vector<unsigned int>();
+	for(unsigned int i = 0; i < 3000; i++) {
+		counts.push_back(100000 + (i * 7919) % 60000);
+	}
+	
+	auto cs = QuantisedSource<unsigned int>(QuantisedCodec<unsigned int>(counts, 64), 150);
+	
+	for(unsigned int i = 0; !cs.eods(); i++) {
+		BOOST_CHECK(std::equal(counts.begin() + i, counts.begin() + i + 150, cs.get())); 
+		
+		if(i == 1000) {
+			auto cp = cs.checkpoint(); 
+			auto b = cs.batch(1000); 
+			BOOST_CHECK(b.rows() > 64 && b.rows() + 150 <= 64 * 5 + 1); 
+			BOOST_CHECK_EQUAL(counts[i + b.rows() - 1], b(b.rows() - 1, 0)); 
+			
+			//Back to the start, and then to here again. 
+			cs.restore(SourceCheckpoint(CheckpointKind::memory, 150, 0)); 
+			BOOST_CHECK(std::equal(counts.begin(), counts.begin() + 150, cs.get())); 
+			cs.restore(cp); 
+		}
+		
+		cs.tick(); 
+	}
+	
+	//Eight bit codes, and a block that doesn't change. 
+	auto flat = vector<float>(300, 2.5f); 
+	auto fs = QuantisedSource<float, uint8_t>(flat, 10);
+	BOOST_CHECK_EQUAL(300 + 2 * 2 * sizeof(double), fs.bytes()); 
+	BOOST_CHECK_EQUAL(2.5f, fs.get()[9]); 
+	
+}
+
+BOOST_AUTO_TEST_CASE(compressed_test) {
+	
+	//A counter that goes up by about the same amount each time. 
+	auto counter = vector<unsigned long>();
+	unsigned long c = 1ul << 40; 
+	for(unsigned int i = 0; i < 10000; i++) {
+		c += 1000 + (i * 7919) % 7; 
+		counter.push_back(c);
+	}
+	
+	auto cs = CompressedSource<unsigned long>(counter, 300);
+	
+	BOOST_CHECK(cs.getcodec().getratio() > 5.0); 
+	
+	unsigned int windows = 0; 
+	while(!cs.eods()) {
+		BOOST_CHECK(std::equal(counter.begin() + windows, counter.begin() + windows + 300, cs.get())); 
+		cs.tick(); 
+		windows++; 
+	}
+	BOOST_CHECK_EQUAL(counter.size() - 299, windows); 
+	
+	//Signed, with wrapping differences. 
+	auto signs = vector<int>{ 0, -1, 2147483647, -2147483647 - 1, 5, 5, 5, -7, 100, -100 };
+	auto ss = CompressedSource<int>(CompressedCodec<int>(signs, 3), 10);
+	BOOST_CHECK(std::equal(signs.begin(), signs.end(), ss.get())); 
+	
+	//Slowly varying telemetry, which repeats itself a lot. 
+	auto telemetry = vector<double>();
+	for(unsigned int i = 0; i < 10000; i++) {
+		telemetry.push_back(20.0 + 0.25 * ((i / 40) % 9));
+	}
+	telemetry[5000] = -0.0; 
+	telemetry[5001] = 1e300; 
+	telemetry[5002] = 3.0e-310; 
+	
+	auto ts = CompressedSource<double>(CompressedCodec<double>(telemetry, 256), 50);
+	
+	BOOST_CHECK(ts.getcodec().getratio() > 20.0); 
+	
+	for(unsigned int i = 0; !ts.eods(); i++) {
+		double * w = ts.get(); 
+		BOOST_CHECK(std::memcmp(telemetry.data() + i, w, 50 * sizeof(double)) == 0); 
+		ts.tick(); 
+	}
+	
+	//Noisy floats, where little can be saved but nothing may be lost. 
+	auto noise = vector<float>();
+	for(unsigned int i = 0; i < 3000; i++) {
+		noise.push_back(std::sin(i * 1.7f) * 1000.0f);
+	}
+	
+	auto ns = CompressedSource<float>(noise, 1000);
+	auto restart = ns.checkpoint(); 
+	for(unsigned int pass = 0; pass < 2; pass++) {
+		for(unsigned int i = 0; !ns.eods(); i++) {
+			BOOST_CHECK(std::memcmp(noise.data() + i, ns.get(), 1000 * sizeof(float)) == 0); 
+			ns.tick(); 
+		}
+		ns.restore(restart); 
+	}
+	
+}
+
+BOOST_AUTO_TEST_CASE(raster_test) {
+	
+	//37 rows of 23, where each element records where it is. 
+	string fn = "/tmp/libsimwindow_raster_" + std::to_string(getpid()); 
+	{
+		std::ofstream out(fn, std::ios::binary); 
+		for(unsigned int r = 0; r < 37; r++) {
+			for(unsigned int c = 0; c < 23; c++) {
+				unsigned int v = r * 1000 + c; 
+				out.write(reinterpret_cast<const char *>(&v), sizeof(v)); 
+			}
+		}
+	}
+	
+	auto rs = RasterSource<unsigned int>(unique_ptr<RasterLoader<unsigned int>>(new RawRasterLoader<unsigned int>(fn, 23)), 5, 4, 3, 2, 3);
+	
+	BOOST_CHECK_EQUAL(23, rs.getpitch()); 
+	
+	unsigned int patches = 0; 
+	
+	for(unsigned int y = 0; y + 5 <= 37; y += 2) {
+		for(unsigned int x = 0; x + 4 <= 23; x += 3) {
+			
+			BOOST_CHECK(!rs.eods()); 
+			BOOST_CHECK_EQUAL(x, rs.getx()); 
+			BOOST_CHECK_EQUAL(y, rs.gety()); 
+			BOOST_CHECK(rs.getheld() >= 5 && rs.getheld() <= 5 + 3); 
+			
+			unsigned int * p = rs.get(); 
+			for(unsigned int r = 0; r < 5; r++) {
+				for(unsigned int c = 0; c < 4; c++) {
+					BOOST_CHECK_EQUAL((y + r) * 1000 + x + c, p[r * rs.getpitch() + c]); 
+				}
+			}
+			
+			rs.tick(); 
+			patches++; 
+			
+		}
+	}
+	
+	BOOST_CHECK_EQUAL(17 * 7, patches); 
+	BOOST_CHECK(rs.eods()); 
+	BOOST_CHECK_THROW(rs.get(), RasterSourceInvalidException); 
+	
+	//Steps bigger than the patch skip rows without holding them. 
+	auto skip = RasterSource<unsigned int>(fn, 23, 2, 23, 1, 10);
+	for(unsigned int y = 0; y < 37; y += 10) {
+		BOOST_CHECK_EQUAL(y * 1000 + 22, skip.get()[22]); 
+		BOOST_CHECK_EQUAL((y + 1) * 1000, skip.get()[23]); 
+		BOOST_CHECK(skip.getheld() <= 4); 
+		skip.tick(); 
+	}
+	BOOST_CHECK(skip.eods()); 
+	
+	BOOST_CHECK_THROW(RasterSource<unsigned int>(fn, 23, 2, 24), RasterSourceInvalidException); 
+	
+	std::remove(fn.c_str()); 
+	
+	//A spectrogram as text. 
+	string tn = "/tmp/libsimwindow_rastertext_" + std::to_string(getpid()); 
+	{
+		std::ofstream out(tn); 
+		out << "0.5, 1.5, 2.5\n\n3.5 4.5 5.5\n6.5,7.5,8.5\n"; 
+	}
+	
+	auto ts = RasterSource<double>(unique_ptr<RasterLoader<double>>(new TextRasterLoader<double>(tn)), 2, 2);
+	double expected[] = { 0.5, 1.5, 3.5, 4.5, 1.5, 2.5, 4.5, 5.5, 3.5, 4.5, 6.5, 7.5, 4.5, 5.5, 7.5, 8.5 }; 
+	for(unsigned int i = 0; i < 4; i++) {
+		BOOST_CHECK(!ts.eods()); 
+		double * p = ts.get(); 
+		for(unsigned int j = 0; j < 4; j++) BOOST_CHECK_EQUAL(expected[i * 4 + j], p[(j / 2) * 3 + j % 2]); 
+		ts.tick(); 
+	}
+	BOOST_CHECK(ts.eods()); 
+	
+	std::remove(tn.c_str()); 
+	
+}
+
+//A queue of work for one thread, which the io threads post to. 
+class EventLoop {
+	
+	private:
+		std::mutex lock; 
+		std::condition_variable wake; 
+		std::deque<std::function<void()>> work; 
+	
+	public:
+		void post(std::function<void()> fn) {
+			{
+				std::lock_guard<std::mutex> guard(lock); 
+				work.push_back(move(fn)); 
+			}
+			wake.notify_one(); 
+		}
+		
+		std::function<void()> next() {
+			std::unique_lock<std::mutex> guard(lock); 
+			wake.wait(guard, [this]() { return !work.empty(); }); 
+			auto fn = move(work.front()); 
+			work.pop_front(); 
+			return fn; 
+		}
+		
+};
+
+BOOST_AUTO_TEST_CASE(eventloop_test) {
+	
+	//Many sources, all driven from this thread without blocking on any of them. 
+	const unsigned int count = 64; 
+	
+	vector<unique_ptr<FileSource<unsigned int>>> sources; 
+	for(unsigned int i = 0; i < count; i++) {
+		sources.push_back(unique_ptr<FileSource<unsigned int>>(new FileSource<unsigned int>("test/data", 5, launch::async))); 
+		sources.back()->setreadbounds(5, 8); 
+	}
+	
+	EventLoop loop; 
+	vector<unsigned int> windows(count, 0); 
+	unsigned int finished = 0; 
+	unsigned int suspended = 0; 
+	bool correct = true; 
+	
+	std::function<void(unsigned int)> step = [&](unsigned int i) {
+		
+		FileSource<unsigned int> & fs = *sources[i]; 
+		
+		while(fs.whenready([&loop, &step, i]() { loop.post([&step, i]() { step(i); }); })) {
+			
+			if(fs.eods()) {
+				finished++; 
+				return; 
+			}
+			
+			for(unsigned int j = 0; j < 5; j++) {
+				if(fs.get()[j] != windows[i] + j) correct = false; 
+			}
+			
+			windows[i]++; 
+			fs.tick(); 
+			
+		}
+		
+		suspended++; 
+		
+	};
+	
+	for(unsigned int i = 0; i < count; i++) loop.post([&step, i]() { step(i); }); 
+	
+	while(finished < count) loop.next()(); 
+	
+	BOOST_CHECK(correct); 
+	BOOST_CHECK(suspended > 0); 
+	for(unsigned int i = 0; i < count; i++) BOOST_CHECK_EQUAL(37, windows[i]); 
+	
+	//A deferred source is loaded by poll() itself. 
+	auto deferred = FileSource<unsigned int>("test/data", 5);
+	BOOST_CHECK(deferred.poll()); 
+	BOOST_CHECK_EQUAL(0, deferred.get()[0]); 
+	
+}
+
+// Ring
+
+BOOST_AUTO_TEST_CASE(ringsource_test) {
+	
+	auto data = vector<unsigned int>();
+	for(unsigned int i = 0; i < 6; i++) {
+		data.push_back(i);
+	}
+	
+	auto fs = RingSource<unsigned int>(data, 5);
+	
+	for(unsigned int i = 0 ; i <= 12; i++)  {
+		
+		for (unsigned int j = 0 ; j < 5; j++) {
+			BOOST_CHECK_EQUAL((i+j) % 6, fs.get()[j]);
+		}
+		
+		fs.tick();
+		
+	}
+	
+}
+
+// Fixed windowsize
+
+BOOST_AUTO_TEST_CASE(fixedwindow_test) {
+	
+	auto data = vector<unsigned int>();
+	for(unsigned int i = 0; i < 30; i++) {
+		data.push_back(i);
+	}
+	
+	static_assert(Window<unsigned int, 5>::size() == 5, "window width should be a constant");
+	
+	auto vs = VectorSource<unsigned int, 5>(data);
+	
+	for(unsigned int i = 0 ; i <= 25; i++)  {
+	
+		BOOST_CHECK(!vs.eods());
+		
+		auto w = vs.window();
+		
+		for (unsigned int j = 0 ; j < w.size(); j++) {
+			BOOST_CHECK_EQUAL(i+j, w[j]);
+		}
+		
+		BOOST_CHECK_EQUAL(i + 4, w.toarray()[4]);
+		
+		vs.tick();
+		
+	}
+	
+	BOOST_CHECK(vs.eods());
+	
+	auto rs = RingSource<unsigned int, 5>(vector<unsigned int>(data.begin(), data.begin() + 6));
+	
+	for(unsigned int i = 0 ; i <= 12; i++)  {
+		
+		for (unsigned int j = 0 ; j < 5; j++) {
+			BOOST_CHECK_EQUAL((i+j) % 6, rs.get()[j]);
+		}
+		
+		rs.tick();
+		
+	}
+	
+	auto fs = FileSource<unsigned int, 10>("test/data", 10);
+	
+	for(unsigned int i = 0 ; i < 30; i++) {
+	
+		BOOST_CHECK(!fs.eods());
+		
+		DataSource<unsigned int> & ds = fs;
+		BOOST_CHECK_EQUAL(10, ds.getwindowsize());
+	
+		for (unsigned int j = 0 ; j < 10; j++) {
+			BOOST_CHECK_EQUAL(i+j, fs.window()[j]);
+		}
+		
+		fs.tick();
+		
+	}
+	
+	BOOST_CHECK_THROW((VectorSource<unsigned int, 5>(data, 6)), WindowSizeMismatchException);
+	
+}
+
+// Shared memory
+
+//Calls probe as each element is written into the ring, so a test can look at
+//a reader while the writer is part way through a batch. 
+struct Probed {
+	unsigned int value; 
+	static std::function<void(unsigned int)> probe; 
+	
+	Probed & operator =(const Probed & other) {
+		value = other.value; 
+		if(probe) probe(value); 
+		return *this; 
+	}
+};
+
+std::function<void(unsigned int)> Probed::probe; 
+
+BOOST_AUTO_TEST_CASE(sharedmemory_test) {
+	
+	string name = "/libsimwindow_test_" + std::to_string(getpid()); 
+	
+	auto writer = SharedMemoryWriter<unsigned int>(name, 64, 5); 
+	
+	for(unsigned int i = 0; i < 10; i++) {
+		writer.push_back(i); 
+	}
+	
+	//Each reader has its own cursor, and can be in another process. 
+	auto a = SharedMemorySource<unsigned int>(name, 5); 
+	
+	pid_t child = fork(); 
+	
+	if(child == 0) {
+		
+		auto b = SharedMemorySource<unsigned int, 3>(name, 3); 
+		
+		unsigned int i = 0; 
+		for( ; !b.eods(); i++) {
+			for (unsigned int j = 0 ; j < 3; j++) {
+				if(b.get()[j] != i+j) _exit(1); 
+			}
+			b.tick(); 
+		}
+		
+		_exit(i == 48 ? 0 : 2); 
+		
+	}
+	
+	//Nobody falls more than the capacity behind, so no data is lost
+	for(unsigned int i = 0 ; i < 40; i++)  {
+		
+		BOOST_CHECK(!a.eods());
+		
+		for (unsigned int j = 0 ; j < 5; j++) {
+			BOOST_CHECK_EQUAL(i+j, a.get()[j]);
+		}
+		
+		a.tick();
+		
+		writer.push_back(10 + i); 
+		
+	}
+	
+	writer.close(); 
+	
+	int status; 
+	waitpid(child, &status, 0); 
+	BOOST_CHECK(WIFEXITED(status)); 
+	BOOST_CHECK_EQUAL(0, WEXITSTATUS(status)); 
+	
+	//44 windows of 5 over 0..49
+	for(unsigned int i = 40 ; i <= 45; i++)  {
+		BOOST_CHECK(!a.eods());
+		BOOST_CHECK_EQUAL(i, a.get()[0]);
+		a.tick();
+	}
+	
+	BOOST_CHECK(a.eods());
+	
+	BOOST_CHECK_THROW((SharedMemorySource<unsigned int>(name, 6)), SharedMemoryInvalidException);
+	BOOST_CHECK_THROW((SharedMemorySource<double>(name, 3)), SharedMemoryInvalidException);
+	
+	//A reader that falls more than the capacity behind finds out. 
+	auto c = SharedMemorySource<unsigned int>(name, 5); 
+	for(unsigned int i = 0 ; i < 70; i++)  writer.push_back(i); 
+	BOOST_CHECK(!c.valid()); 
+	BOOST_CHECK_THROW(c.get(), SharedMemoryOverrunException);
+	
+	//A window stops being valid as soon as a batch that will overwrite it 
+	//starts, not once the batch has been published. 
+	string probename = name + "_probed"; 
+	auto pw = SharedMemoryWriter<Probed>(probename, 16, 4); 
+	
+	Probed values[16]; 
+	for(unsigned int i = 0; i < 16; i++) values[i].value = i; 
+	pw.push_back(values, 8); 
+	
+	auto p = SharedMemorySource<Probed>(probename, 4); 
+	BOOST_CHECK_EQUAL(0, p.get()[0].value); 
+	
+	bool before = true; 
+	bool during = true; 
+	Probed::probe = [&](unsigned int v) {
+		//values 8 to 15 are elements 8 to 15, in slots 8 to 15; 16 to 19 wrap
+		//round onto the reader's window at 0. 
+		if(v == 8) before = p.valid(); 
+		if(v == 16) during = p.valid(); 
+	}; 
+	
+	for(unsigned int i = 0; i < 16; i++) values[i].value = 8 + i; 
+	pw.push_back(values, 8); 
+	BOOST_CHECK(before); 
+	BOOST_CHECK(p.valid()); 
+	
+	pw.push_back(values + 8, 4); 
+	Probed::probe = std::function<void(unsigned int)>(); 
+	
+	BOOST_CHECK(!during); 
+	BOOST_CHECK(!p.valid()); 
+	
+}
+
+// Sqlite
+
+// Time windows
+
+BOOST_AUTO_TEST_CASE(timewindow_test) {
+	
+	//test/timed is irregularly sampled; each window is the last second. 
+	auto ts = TimeWindowSource<unsigned int>(unique_ptr<TimedLoader<unsigned int>>(new TimedFileLoader<unsigned int>("test/timed")), 1.0, 0.0, 3);
+	
+	unsigned int firsts[] = { 0, 0, 0, 1, 4, 4, 6, 7, 7, 7 }; 
+	
+	for(unsigned int i = 0; i < 10; i++) {
+		
+		BOOST_CHECK(!ts.eods());
+		BOOST_CHECK_EQUAL(i - firsts[i] + 1, ts.size()); 
+		
+		for(unsigned int j = 0; j < ts.size(); j++) {
+			BOOST_CHECK_EQUAL(firsts[i] + j, ts.get()[j]); 
+		}
+		
+		BOOST_CHECK_EQUAL(ts.getend(), ts.times()[ts.size() - 1]); 
+		BOOST_CHECK(ts.times()[0] > ts.getend() - 1.0); 
+		
+		ts.tick(); 
+		
+	}
+	
+	BOOST_CHECK(ts.eods());
+	BOOST_CHECK_THROW(ts.get(), TimeWindowSourceInvalidException);
+	
+	//On a grid of 2s steps, windows over the gap are empty. 
+	auto gs = TimeWindowSource<unsigned int>("test/timed", 2.0, 2.0);
+	
+	unsigned int sizes[] = { 1, 3, 3, 0, 3 }; 
+	
+	for(auto size : sizes) {
+		BOOST_CHECK(!gs.eods());
+		BOOST_CHECK_EQUAL(size, gs.size()); 
+		gs.tick(); 
+	}
+	
+	BOOST_CHECK(gs.eods());
+	
+	sqlite3 * database;
+	sqlite3_open("test/testdb", &database);
+	
+	{
+		string sql = "SELECT num * 0.5, num from test LIMIT ? OFFSET ?;";
+		auto ss = TimeWindowSource<double>(unique_ptr<TimedLoader<double>>(new TimedSQLiteLoader<double>(database, sql)), 1.0, 0.0, 16);
+		
+		ss.tick(); 
+		
+		for(unsigned int i = 2; i <= 50; i++) {
+			BOOST_CHECK_EQUAL(2u, ss.size()); 
+			BOOST_CHECK_EQUAL(i - 1.0, ss.get()[0]); 
+			BOOST_CHECK_EQUAL(i * 0.5, ss.times()[1]); 
+			ss.tick(); 
+		}
+		
+		BOOST_CHECK(ss.eods());
+	}
+	
+	sqlite3_close(database);
+	
+}
+
+// Merging
+
+BOOST_AUTO_TEST_CASE(merge_test) {
+	
+	auto inputs = []() {
+		vector<unique_ptr<TimedLoader<double>>> loaders; 
+		loaders.push_back(unique_ptr<TimedLoader<double>>(new TimedFileLoader<double>("test/timed"))); 
+		loaders.push_back(unique_ptr<TimedLoader<double>>(new TimedFileLoader<double>("test/timed2"))); 
+		return loaders; 
+	};
+	
+	double asoftimes[] = { 0.5, 0.7, 1.0, 2.0, 2.5, 2.6, 4.0, 7.0, 7.1, 7.2, 8.0 }; 
+	double asofa[] = { 1, 2, 3, 3, 4, 5, 6, 7, 8, 9, 9 }; 
+	double asofb[] = { 10, 10, 20, 30, 30, 30, 40, 40, 40, 40, 50 }; 
+	
+	auto ms = MergeSource<double>(inputs(), 3, MergeAlignment::asof, 2);
+	BOOST_CHECK_EQUAL(2u, ms.channels()); 
+	
+	for(unsigned int i = 0; i <= 8; i++) {
+		
+		BOOST_CHECK(!ms.eods());
+		
+		for(unsigned int j = 0; j < 3; j++) {
+			BOOST_CHECK_EQUAL(asoftimes[i+j], ms.times()[j]); 
+			BOOST_CHECK_EQUAL(asofa[i+j], ms.get(0)[j]); 
+			BOOST_CHECK_EQUAL(asofb[i+j], ms.get(1)[j]); 
+		}
+		
+		ms.tick(); 
+		
+	}
+	
+	BOOST_CHECK(ms.eods());
+	
+	auto es = MergeSource<double>(inputs(), 1, MergeAlignment::exact);
+	
+	double exacttimes[] = { 0.5, 1.0, 4.0 }; 
+	double exacta[] = { 1, 3, 6 }; 
+	
+	for(unsigned int i = 0; i < 3; i++) {
+		BOOST_CHECK_EQUAL(exacttimes[i], es.times()[0]); 
+		BOOST_CHECK_EQUAL(exacta[i], es.get(0)[0]); 
+		BOOST_CHECK_EQUAL(10.0 * (i == 0 ? 1 : (i == 1 ? 2 : 4)), es.get(1)[0]); 
+		es.tick(); 
+	}
+	
+	BOOST_CHECK(es.eods());
+	
+	auto is = MergeSource<double>(inputs(), 1, MergeAlignment::interpolated);
+	
+	double interpa[] = { 1, 2, 3, 3.0 + 1.0 / 1.5, 4, 5, 6, 7, 8, 9 }; 
+	double interpb[] = { 10, 14, 20, 30, 32.5, 33, 40, 47.5, 47.75, 48 }; 
+	
+	for(unsigned int i = 0; i < 10; i++) {
+		BOOST_CHECK(!is.eods());
+		BOOST_CHECK_CLOSE(interpa[i], is.get(0)[0], 1e-9); 
+		BOOST_CHECK_CLOSE(interpb[i], is.get(1)[0], 1e-9); 
+		is.tick(); 
+	}
+	
+	BOOST_CHECK(is.eods());
+	BOOST_CHECK_THROW(is.get(0), MergeSourceInvalidException);
+	
+}
+
+BOOST_AUTO_TEST_CASE(sqlite3_test) {
+
+  
+	sqlite3 * database;
+	sqlite3_open("test/testdb", &database);
+	
+	string sql = "SELECT * from test LIMIT ? OFFSET ?;";
+	
+	auto fs = SQLiteSource<unsigned int>(database, sql, 5);
+	
+	for(unsigned int i = 1 ; i <= 40; i++)  {
+		
+		for (unsigned int j = 0 ; j < 5; j++) {
+			BOOST_CHECK_EQUAL(i+j, fs.get()[j]);
+		}
+		
+		fs.tick();
+		
+	}
+	
+	sqlite3_close(database);
+	
+}
+
+
+
+BOOST_AUTO_TEST_CASE(sqlite3_adaptive_test) {
+
+	sqlite3 * database;
+	sqlite3_open("test/testdb", &database);
+	
+	string sql = "SELECT * from test LIMIT ? OFFSET ?;";
+	
+	{
+		auto fs = SQLiteSource<unsigned int>(database, sql, 5, launch::async);
+		
+		//Small bounds force many refills of varying size. 
+		fs.setreadbounds(1, 7);
+		
+		for(unsigned int i = 1 ; i <= 46; i++)  {
+			
+			BOOST_CHECK(!fs.eods());
+			
+			for (unsigned int j = 0 ; j < 5; j++) {
+				BOOST_CHECK_EQUAL(i+j, fs.get()[j]);
+			}
+			
+			fs.tick();
+			
+		}
+		
+		BOOST_CHECK(fs.eods());
+		BOOST_CHECK(fs.eods());
+	}
+	
+	sqlite3_close(database);
+	
+}
+
+BOOST_AUTO_TEST_CASE(governor_test) {
+	
+	BufferGovernor & governor = BufferGovernor::instance(); 
+	
+	size_t before = governor.getsources(); 
+	
+	string fn = "/tmp/libsimwindow_budget_" + std::to_string(getpid()); 
+	{
+		std::ofstream out(fn); 
+		for(unsigned int i = 0; i < 20000; i++) out << i << "\n"; 
+	}
+	
+	//Each source on its own, so that only their buffers count. 
+	bool sharing = ParseRegistry::instance().isenabled(); 
+	ParseRegistry::instance().setenabled(false); 
+	
+	const unsigned int windowsize = 5; 
+	
+	//Two sources reading side by side hold the most they can at the step 
+	//they get to. 
+	auto walk = [&](size_t budget) -> size_t {
+		
+		governor.setbudget(budget); 
+		
+		auto a = FileSource<unsigned int>(fn, windowsize, launch::async); 
+		auto b = FileSource<unsigned int>(fn, windowsize, launch::async); 
+		
+		BOOST_CHECK_EQUAL(before + 2, governor.getsources()); 
+		
+		size_t most = 0; 
+		for(unsigned int i = 0 ; i < 15000; i++) {
+			
+			if(a.get()[windowsize - 1] != i + windowsize - 1 || b.get()[0] != i) {
+				BOOST_ERROR("window " << i << " differs"); 
+				break; 
+			}
+			
+			a.tick(); 
+			b.tick(); 
+			
+			size_t usage = governor.getusage(); 
+			most = std::max(most, usage); 
+			
+			//The budget, and a window of progress for each. 
+			if(budget != numeric_limits<size_t>::max() && usage > budget + 2 * windowsize * sizeof(unsigned int)) {
+				BOOST_ERROR("usage " << usage << " over budget at window " << i); 
+				break; 
+			}
+			
+		}
+		
+		return most; 
+		
+	}; 
+	
+	size_t unbounded = walk(numeric_limits<size_t>::max()); 
+	size_t bounded = walk(2 * 8 * sizeof(unsigned int)); 
+	
+	BOOST_CHECK(bounded > 0); 
+	BOOST_CHECK(bounded < unbounded); 
+	
+	governor.setbudget(numeric_limits<size_t>::max()); 
+	ParseRegistry::instance().setenabled(sharing); 
+	std::remove(fn.c_str()); 
+	
+	BOOST_CHECK_EQUAL(before, governor.getsources()); 
+	
+}
+
+BOOST_AUTO_TEST_CASE(governor_idle_test) {
+	
+	BufferGovernor & governor = BufferGovernor::instance(); 
+	
+	string fn = "/tmp/libsimwindow_idle_" + std::to_string(getpid()); 
+	{
+		std::ofstream out(fn); 
+		for(unsigned int i = 0; i < 10000; i++) out << i << "\n"; 
+	}
+	
+	{
+		//A source that reads in big loads, then goes quiet. 
+		auto a = FileSource<unsigned int>(fn, 5); 
+		a.setreadbounds(4096, 4096); 
+		for(unsigned int i = 0; i < 3000; i++) a.tick(); 
+		
+		size_t held = a.getheld(); 
+		BOOST_CHECK(held > 1024); 
+		
+		governor.setidletimeout(0.0); 
+		governor.setbudget(1024); 
+		
+		//Someone else reading puts the governor over budget, and the idle 
+		//source gives back what it has consumed as soon as it is next used. 
+		auto b = FileSource<unsigned int>("test/data", 5); 
+		BOOST_CHECK_EQUAL(0, b.get()[0]); 
+		
+		BOOST_CHECK_EQUAL(3004, a.get()[4]); 
+		BOOST_CHECK(a.getheld() < held); 
+		
+		//And carries on where it was. 
+		a.tick(); 
+		BOOST_CHECK_EQUAL(3001, a.get()[0]); 
+	}
+	
+	governor.setbudget(numeric_limits<size_t>::max()); 
+	governor.setidletimeout(1.0); 
+	
+	std::remove(fn.c_str()); 
+	
+}
+
+// Random access
+
+BOOST_AUTO_TEST_CASE(randomaccess_test) {
+	
+	//Small blocks, so lookups cross blocks and hit the cache. 
+	auto fs = RandomAccessSource<unsigned int>("test/data", 5, 8);
+	
+	unsigned int order[] = { 30, 3, 31, 12, 0, 36, 17, 30 }; 
+	
+	for(auto i : order) {
+		for (unsigned int j = 0 ; j < 5; j++) {
+			BOOST_CHECK_EQUAL(i+j, fs.windowat(i)[j]);
+		}
+	}
+	
+	BOOST_CHECK(!fs.haswindow(37)); 
+	BOOST_CHECK_THROW(fs.windowat(100), RandomAccessOutOfRangeException);
+	
+	for(unsigned int i = 0 ; i <= 36; i++)  {
+		BOOST_CHECK(!fs.eods());
+		BOOST_CHECK_EQUAL(i, fs.get()[0]);
+		fs.tick();
+	}
+	
+	BOOST_CHECK(fs.eods());
+	BOOST_CHECK(BlockCache::instance().gethits() > 0); 
+	
+	sqlite3 * database;
+	sqlite3_open("test/testdb", &database);
+	
+	{
+		string sql = "SELECT * from test LIMIT ? OFFSET ?;";
+		auto ss = RandomAccessSource<double>(unique_ptr<BlockLoader<double>>(new SQLiteBlockLoader<double>(database, sql)), 5, 16);
+		
+		BOOST_CHECK_EQUAL(41.0, ss.windowat(40)[0]); 
+		BOOST_CHECK_EQUAL(50.0, ss.windowat(45)[4]); 
+		BOOST_CHECK_EQUAL(7.0, ss.windowat(2)[4]); 
+		BOOST_CHECK(!ss.haswindow(46)); 
+	}
+	
+	sqlite3_close(database);
+	
+	//Nothing is cached past the end of the data. 
+	{
+		unsigned long misses = BlockCache::instance().getmisses(); 
+		auto p = RandomAccessSource<unsigned int>("test/data", 5, 8);
+		auto q = RandomAccessSource<unsigned int>("test/data", 5, 8);
+		BOOST_CHECK(!p.haswindow(1000)); 
+		BOOST_CHECK(!q.haswindow(1000)); 
+		BOOST_CHECK_EQUAL(misses + 2, BlockCache::instance().getmisses()); 
+	}
+	
+	//A file that is rewritten isn't served from its old blocks. 
+	string fn = "/tmp/libsimwindow_blocks_" + std::to_string(getpid()); 
+	{
+		std::ofstream out(fn); 
+		for(unsigned int i = 0; i < 100; i++) out << i << "\n"; 
+	}
+	{
+		auto before = RandomAccessSource<unsigned int>(fn, 5, 8);
+		BOOST_CHECK_EQUAL(10, before.windowat(10)[0]); 
+	}
+	{
+		std::ofstream out(fn); 
+		for(unsigned int i = 0; i < 200; i++) out << i * 2 << "\n"; 
+	}
+	{
+		auto after = RandomAccessSource<unsigned int>(fn, 5, 8);
+		BOOST_CHECK_EQUAL(20, after.windowat(10)[0]); 
+	}
+	std::remove(fn.c_str()); 
+	
+}
+
+BOOST_AUTO_TEST_CASE(checkpoint_test) {
+	
+	std::stringstream saved; 
+	
+	{
+		auto fs = FileSource<unsigned int>("test/data", 5);
+		for(unsigned int i = 0; i < 17; i++) fs.tick(); 
+		fs.checkpoint().write(saved); 
+	}
+	
+	{
+		auto fs = FileSource<unsigned int>("test/data", 5);
+		fs.restore(SourceCheckpoint::read(saved)); 
+		
+		for(unsigned int i = 17 ; i <= 36; i++) {
+			BOOST_CHECK(!fs.eods());
+			BOOST_CHECK_EQUAL(i, fs.get()[0]);
+			fs.tick();
+		}
+		
+		BOOST_CHECK(fs.eods());
+	}
+	
+	{
+		auto ms = MultiFileSource<unsigned int>(vector<string>{ "test/data", "test/data" }, 5);
+		for(unsigned int i = 0; i < 50; i++) ms.tick(); 
+		auto cp = ms.checkpoint(); 
+		BOOST_CHECK_EQUAL(1u, cp.segment); 
+		
+		auto rs = MultiFileSource<unsigned int>(vector<string>{ "test/data", "test/data" }, 5);
+		rs.restore(cp); 
+		BOOST_CHECK_EQUAL(9u, rs.get()[0]); 
+		BOOST_CHECK_EQUAL(13u, rs.get()[4]); 
+	}
+	
+	//A checkpoint past the end of the data is refused, and the source carries 
+	//on from where it was. 
+	{
+		SourceCheckpoint beyond(CheckpointKind::file, 5, 100); 
+		beyond.base = 0; 
+		
+		auto fs = FileSource<unsigned int>("test/data", 5, launch::async);
+		for(unsigned int i = 0; i < 10; i++) fs.tick(); 
+		BOOST_CHECK_THROW(fs.restore(beyond), CheckpointInvalidException);
+		
+		for(unsigned int i = 10 ; i <= 36; i++) {
+			BOOST_CHECK(!fs.eods());
+			BOOST_CHECK_EQUAL(i, fs.get()[0]);
+			fs.tick();
+		}
+		BOOST_CHECK(fs.eods());
+		
+		SourceCheckpoint mbeyond(CheckpointKind::multifile, 5, 100); 
+		mbeyond.base = 0; 
+		mbeyond.segment = 1; 
+		
+		auto ms = MultiFileSource<unsigned int>(vector<string>{ "test/data", "test/data" }, 5);
+		for(unsigned int i = 0; i < 45; i++) ms.tick(); 
+		BOOST_CHECK_THROW(ms.restore(mbeyond), CheckpointInvalidException);
+		
+		for(unsigned int i = 45 ; i < 78; i++) {
+			BOOST_CHECK(!ms.eods());
+			BOOST_CHECK_EQUAL(i % 41, ms.get()[0]);
+			ms.tick();
+		}
+		BOOST_CHECK(ms.eods());
+	}
+	
+	//Before the first load is in, the checkpoint is the start of the data. 
+	{
+		auto fs = FileSource<unsigned int>("test/data", 5, launch::async);
+		auto cp = fs.checkpoint(); 
+		BOOST_CHECK_EQUAL(0u, cp.index); 
+		BOOST_CHECK_EQUAL(0u, cp.base); 
+		BOOST_CHECK_EQUAL(0u, cp.offset); 
+		
+		auto ms = MultiFileSource<unsigned int>(vector<string>{ "test/data", "test/data" }, 5, launch::async);
+		auto mcp = ms.checkpoint(); 
+		BOOST_CHECK_EQUAL(0u, mcp.index); 
+		BOOST_CHECK_EQUAL(0u, mcp.segment); 
+		BOOST_CHECK_EQUAL(0u, mcp.offset); 
+	}
+	
+	//A source that is never checkpointed doesn't keep a mark for every load.
+	{
+		string fn = "/tmp/libsimwindow_marks_" + std::to_string(getpid()); 
+		{
+			std::ofstream out(fn); 
+			for(unsigned int i = 0; i < 10000; i++) out << i << "\n"; 
+		}
+		
+		auto fs = FileSource<unsigned int>(fn, 5, launch::async);
+		fs.setreadbounds(5, 8); 
+		for(unsigned int i = 0; i < 9000; i++) fs.tick(); 
+		BOOST_CHECK_EQUAL(9000u, fs.get()[0]); 
+		BOOST_CHECK(fs.getmarks() <= 4); 
+		
+		std::remove(fn.c_str()); 
+	}
+	
+	sqlite3 * database;
+	sqlite3_open("test/testdb", &database);
+	
+	{
+		string sql = "SELECT * from test LIMIT ? OFFSET ?;";
+		auto ss = SQLiteSource<unsigned int>(database, sql, 5);
+		for(unsigned int i = 0; i < 25; i++) ss.tick(); 
+		
+		auto rs = SQLiteSource<unsigned int>(database, sql, 5);
+		rs.restore(ss.checkpoint()); 
+		BOOST_CHECK_EQUAL(26u, rs.get()[0]); 
+		
+		//A checkpoint from another kind of source, or another windowsize, is refused. 
+		BOOST_CHECK_THROW(rs.restore(SourceCheckpoint(CheckpointKind::file, 5, 3)), CheckpointInvalidException);
+		BOOST_CHECK_THROW(rs.restore(SourceCheckpoint(CheckpointKind::sqlite, 4, 3)), CheckpointInvalidException);
+	}
+	
+	sqlite3_close(database);
+	
+	auto data = vector<unsigned int>();
+	for(unsigned int i = 0; i < 6; i++) {
+		data.push_back(i);
+	}
+	
+	auto vs = VectorSource<unsigned int>(data, 3);
+	vs.tick(); 
+	vs.tick(); 
+	auto vcp = vs.checkpoint(); 
+	
+	auto vr = VectorSource<unsigned int>(data, 3);
+	vr.restore(vcp); 
+	BOOST_CHECK_EQUAL(2u, vr.get()[0]); 
+	
+	auto rs = RingSource<unsigned int>(data, 5);
+	for(unsigned int i = 0; i < 10; i++) rs.tick(); 
+	
+	auto rr = RingSource<unsigned int>(data, 5);
+	rr.restore(rs.checkpoint()); 
+	BOOST_CHECK_EQUAL(4u, rr.get()[0]); 
+	BOOST_CHECK_EQUAL(2u, rr.get()[4]); 
+	
+	std::stringstream junk("not a checkpoint at all, not at all"); 
+	BOOST_CHECK_THROW(SourceCheckpoint::read(junk), CheckpointInvalidException);
+	
+}